@@ -3,6 +3,7 @@
 #include <vector>
 #include <cmath>
 #include <stdexcept>
+#include <cstdint>
 
 class SparseMatrix {
 public:
@@ -20,6 +21,45 @@ public:
         }
     }
 
+    // Method to create a sparse matrix from compressed sparse row arrays: row i holds the entries
+    // rowOffsets[i]..rowOffsets[i+1]-1 of columns and values (the layout the graph module exports).
+    // Replaces any entries the matrix had
+    void fromCompressed(const std::vector<size_t>& rowOffsets, const std::vector<uint32_t>& columns,
+                        const std::vector<double>& values) {
+        if (rowOffsets.empty() || rowOffsets.back() != columns.size() || columns.size() != values.size()) {
+            throw std::invalid_argument("Inconsistent compressed arrays");
+        }
+        data.clear();
+        for (size_t i = 0; i + 1 < rowOffsets.size(); ++i) {
+            for (size_t e = rowOffsets[i]; e < rowOffsets[i + 1]; ++e) {
+                if (values[e] != 0) {
+                    data[{i, columns[e]}] = values[e];
+                }
+            }
+        }
+    }
+
+    // Method to export the nonzero entries as compressed sparse row arrays with numRows rows
+    void toCompressed(size_t numRows, std::vector<size_t>& rowOffsets, std::vector<uint32_t>& columns,
+                      std::vector<double>& values) const {
+        rowOffsets.assign(numRows + 1, 0);
+        columns.clear();
+        values.clear();
+        for (const auto& item : data) {  // The map is ordered by (row, column)
+            if (item.first.first >= numRows) {
+                throw std::out_of_range("Entry outside the requested rows");
+            }
+            if (item.second != 0) {
+                rowOffsets[item.first.first + 1]++;
+                columns.push_back(static_cast<uint32_t>(item.first.second));
+                values.push_back(item.second);
+            }
+        }
+        for (size_t i = 0; i < numRows; ++i) {
+            rowOffsets[i + 1] += rowOffsets[i];
+        }
+    }
+
     // Overload subscript operator for accessing elements
     double& operator()(size_t i, size_t j) {
         return data[{i, j}];
@@ -74,6 +114,27 @@ public:
         return result;
     }
 
+    // Method to multiply by a vector, giving a result with numRows rows; rows without entries give 0
+    std::vector<double> multiply(const std::vector<double>& vec, size_t numRows) const {
+        std::vector<double> result(numRows, 0.0);
+        for (const auto& item : data) {
+            if (item.first.first >= numRows) {
+                throw std::out_of_range("Entry outside the requested rows");
+            }
+            if (item.first.second >= vec.size()) {
+                throw std::invalid_argument("Vector is shorter than the matrix width");
+            }
+            result[item.first.first] += item.second * vec[item.first.second];
+        }
+        return result;
+    }
+
+    // Overload matrix-vector multiplication. The matrix does not store its height, so the result
+    // ends at the last row with an entry; use multiply to keep trailing empty rows
+    std::vector<double> operator*(const std::vector<double>& vec) const {
+        return multiply(vec, data.empty() ? 0 : data.rbegin()->first.first + 1);
+    }
+
     // Overload scalar multiplication
     SparseMatrix operator*(double scalar) const {
         SparseMatrix result;
@@ -4,20 +4,213 @@
 #include <algorithm>    // std::find
 #include <list>         // std::list
 #include <map>          // std::map
+#include <deque>        // std::deque
+#include <unordered_map> // std::unordered_map
+#include <unordered_set> // std::unordered_set
+#include <stdexcept>    // std::underflow_error
+#include <cstdint>      // uint32_t
+#include <thread>       // std::thread
+#include <atomic>       // std::atomic
+#include <mutex>        // std::mutex
+#include <condition_variable> // std::condition_variable
+#include <functional>   // std::function
+#include <cstring>      // std::memcpy
+#include <cstdio>       // std::rename
+#include <cstdlib>      // mkstemp
+#include <fcntl.h>      // open
+#include <sys/mman.h>   // mmap
+#include <sys/stat.h>   // fstat
+#include <unistd.h>     // close
 #include <string>
+#include <string_view>  // std::string_view
+#include <charconv>     // std::from_chars
 #include <vector>
 #include <limits>
+#include <cmath>        // std::fabs
 using namespace std;
 
+// Sentinel used by the dense-id graph code for "no vertex", e.g. the previous vertex of a source.
+const uint32_t NO_VERTEX = numeric_limits<uint32_t>::max();
+
+/**
+ * Returns the number of worker threads used by the parallel graph algorithms when the caller
+ * passes 0: the number of hardware threads, or 1 if that is unknown.
+ */
+unsigned defaultThreadCount() {
+    unsigned n = thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+/**
+ * Splits the index range [0, n) into one contiguous chunk per thread and runs body on every chunk
+ * in parallel. The calling thread processes the first chunk itself. Returns when all chunks are done.
+ *
+ * Args:
+ *     n (size_t): The size of the index range.
+ *     numThreads (unsigned): The maximum number of threads to use.
+ *     body (Function): Called as body(begin, end, threadIndex) with threadIndex < numThreads.
+ */
+template<typename Function>
+void parallelFor(size_t n, unsigned numThreads, Function body) {
+    if (numThreads > n) {
+        numThreads = n == 0 ? 1 : static_cast<unsigned>(n);
+    }
+    size_t chunk = (n + numThreads - 1) / numThreads;
+    vector<thread> workers;
+    for (unsigned t = 1; t < numThreads; t++) {
+        size_t begin = min(n, t * chunk);
+        size_t end = min(n, begin + chunk);
+        workers.emplace_back(body, begin, end, t);
+    }
+    body(size_t(0), min(n, chunk), 0u);
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * Interns vertex identifiers: every distinct string key is mapped to a dense 32-bit id exactly
+ * once, so the rest of the graph can work with integer ids instead of comparing and copying strings.
+ * Ids are assigned consecutively from 0 in first-seen order and never change.
+ *
+ * Keys are stored once, in a deque so that they never move, and the hash index refers to them
+ * through string_views. Lookups therefore accept any string_view, e.g. a token in a file buffer,
+ * without building a string first.
+ *
+ * Attributes:
+ *     ids (unordered_map<string_view, uint32_t>): Maps each key to its id.
+ *     names (deque<string>): Maps each id back to its key.
+ */
+class KeyInterner {
+public:
+    KeyInterner() {}
+
+    KeyInterner(const KeyInterner& other) : names(other.names) {
+        rebuildIndex();
+    }
+
+    KeyInterner& operator=(const KeyInterner& other) {
+        if (this != &other) {
+            names = other.names;
+            rebuildIndex();
+        }
+        return *this;
+    }
+
+    KeyInterner(KeyInterner&&) = default;
+    KeyInterner& operator=(KeyInterner&&) = default;
+
+    /**
+     * Returns the id of a key, assigning the next free id if the key is new.
+     *
+     * Args:
+     *     key (string_view): The key to intern.
+     *
+     * Returns:
+     *     uint32_t: The id of the key.
+     */
+    uint32_t intern(string_view key) {
+        auto it = ids.find(key);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        uint32_t id = static_cast<uint32_t>(names.size());
+        names.emplace_back(key);
+        ids.emplace(string_view(names.back()), id);
+        return id;
+    }
+
+    /**
+     * Looks up the id of a key without interning it.
+     *
+     * Args:
+     *     key (string_view): The key to look up.
+     *
+     * Returns:
+     *     uint32_t: The id of the key, or NO_VERTEX if the key has not been interned.
+     */
+    uint32_t find(string_view key) const {
+        auto it = ids.find(key);
+        return it == ids.end() ? NO_VERTEX : it->second;
+    }
+
+    /**
+     * Returns the key that was interned as the given id.
+     *
+     * Args:
+     *     id (uint32_t): An id previously returned by intern.
+     */
+    const string& name(uint32_t id) const {
+        return names[id];
+    }
+
+    /**
+     * Returns the number of interned keys.
+     */
+    size_t size() const {
+        return names.size();
+    }
+
+    /**
+     * Preallocates room for n keys in the hash index.
+     */
+    void reserve(size_t n) {
+        ids.reserve(n);
+    }
+
+private:
+    unordered_map<string_view, uint32_t> ids;
+    deque<string> names;
+
+    void rebuildIndex() {
+        ids.clear();
+        ids.reserve(names.size());
+        for (size_t id = 0; id < names.size(); id++) {
+            ids.emplace(string_view(names[id]), static_cast<uint32_t>(id));
+        }
+    }
+};
+
+/**
+ * A weighted edge between two interned vertex ids, used by the bulk edge APIs.
+ *
+ * Attributes:
+ *     from (uint32_t): The id of the from vertex.
+ *     to (uint32_t): The id of the to vertex.
+ *     weight (float): The weight of the edge.
+ */
+struct Edge {
+    uint32_t from;
+    uint32_t to;
+    float weight;
+};
+
+/**
+ * One change in a batch passed to Graph::applyUpdates: an edge to insert (or reweight) or to delete.
+ *
+ * Attributes:
+ *     from (uint32_t): The id of the from vertex.
+ *     to (uint32_t): The id of the to vertex.
+ *     weight (float): The weight of an inserted edge. For a deletion reported by applyUpdates, the weight the edge had.
+ *     remove (bool): True to delete the edge, false to insert it.
+ */
+struct EdgeUpdate {
+    uint32_t from;
+    uint32_t to;
+    float weight;
+    bool remove;
+};
+
 /**
  * Represents a single vertex in a graph, containing methods and attributes for maintaining
  * graph properties and interactions with other vertices.
  * 
  * Attributes:
  *     id (string): Unique identifier of the vertex.
- *     connectedTo (map<string, float>): Adjacency list mapping neighbor ID to edge weight.
+ *     index (uint32_t): Interned id of the vertex, its position in the owning graph's vertex list.
+ *     connectedTo (map<uint32_t, float>): Adjacency list mapping neighbor index to edge weight.
  *     color (string): Vertex color for traversal, e.g., "white", "gray", "black".
- *     previous (Vertex*): Pointer to previous vertex in the shortest path or traversal.
+ *     previous (uint32_t): Index of the previous vertex in the shortest path or traversal, NO_VERTEX for none.
  *     discovery_time (int): Discovery time in depth-first search.
  *     closing_time (int): Closing time in depth-first search.
  *     distance (int): Distance from the source vertex, initialized to infinity.
@@ -25,9 +218,10 @@ using namespace std;
 class Vertex {
 public:
     string id;
-    map<string, float> connectedTo;
+    uint32_t index;
+    map<uint32_t, float> connectedTo;
     string color;
-    Vertex* previous;
+    uint32_t previous;
     int discovery_time;
     int closing_time;
     int distance;
@@ -35,35 +229,36 @@ public:
     /**
      * Default constructor that initializes vertex with empty or default attributes.
      */
-    Vertex() : id(""), color("white"), previous(nullptr), discovery_time(0), closing_time(0), distance(numeric_limits<int>::max()) {}
+    Vertex() : id(""), index(NO_VERTEX), color("white"), previous(NO_VERTEX), discovery_time(0), closing_time(0), distance(numeric_limits<int>::max()) {}
 
     /**
      * Constructor that initializes a vertex with a specific identifier.
      * 
      * Args:
      *     key (string): The unique identifier for the vertex.
+     *     idx (uint32_t): The interned id of the vertex.
      */
-    Vertex(string key) : id(key), color("white"), previous(nullptr), discovery_time(0), closing_time(0), distance(numeric_limits<int>::max()) {}
+    Vertex(const string& key, uint32_t idx) : id(key), index(idx), color("white"), previous(NO_VERTEX), discovery_time(0), closing_time(0), distance(numeric_limits<int>::max()) {}
 
     /**
      * Adds a neighbor to this vertex with an optional weight.
      * 
      * Args:
-     *     nbr (string): The identifier of the neighbor vertex.
+     *     nbr (uint32_t): The index of the neighbor vertex.
      *     weight (float): The weight of the edge connecting to the neighbor, defaulting to 1.0.
      */
-    void addNeighbor(string nbr, float weight = 1) {
+    void addNeighbor(uint32_t nbr, float weight = 1) {
         connectedTo[nbr] = weight;
     }
 
     /**
-     * Returns a vector of identifiers for all direct neighbors of this vertex.
+     * Returns a vector of indices for all direct neighbors of this vertex.
      * 
      * Returns:
-     *     vector<string>: A vector of neighbor identifiers.
+     *     vector<uint32_t>: A vector of neighbor indices.
      */
-    vector<string> getConnections() const {
-        vector<string> keys;
+    vector<uint32_t> getConnections() const {
+        vector<uint32_t> keys;
         for (auto it = connectedTo.begin(); it != connectedTo.end(); ++it) {
             keys.push_back(it->first);
         }
@@ -84,7 +279,7 @@ public:
      * Returns the weight of the edge connecting this vertex to a given neighbor.
      * 
      * Args:
-     *     nbr (string): The identifier of the neighbor.
+     *     nbr (uint32_t): The index of the neighbor.
      * 
      * Returns:
      *     float: The weight of the edge to the specified neighbor.
@@ -92,21 +287,40 @@ public:
      * Throws:
      *     runtime_error: If the neighbor is not found in the adjacency list.
      */
-    float getWeight(const string& nbr) const {
-        if (connectedTo.find(nbr) != connectedTo.end()) {
-            return connectedTo.at(nbr);
+    float getWeight(uint32_t nbr) const {
+        auto it = connectedTo.find(nbr);
+        if (it != connectedTo.end()) {
+            return it->second;
         }
         throw std::runtime_error("Neighbor not found");
     }
 
     /**
      * Provides a string representation of the vertex for easy debugging and display.
+     * The previous vertex is printed by index; pass the graph's keys to print its identifier.
      * 
      * Returns:
      *     string: A string representing the vertex details.
      */
     string to_string() const {
-        string prev_id = (previous ? previous->id : "None");
+        return describe(previous == NO_VERTEX ? "None" : "#" + std::to_string(previous));
+    }
+
+    /**
+     * Provides a string representation of the vertex, naming the previous vertex by identifier.
+     *
+     * Args:
+     *     keys (KeyInterner): The interned keys of the graph that owns this vertex.
+     *
+     * Returns:
+     *     string: A string representing the vertex details.
+     */
+    string to_string(const KeyInterner& keys) const {
+        return describe(previous == NO_VERTEX ? "None" : keys.name(previous));
+    }
+
+private:
+    string describe(const string& prev_id) const {
         string distance_str = (distance == numeric_limits<int>::max()) ? "inf" : std::to_string(distance);
         return id + " | " + color + " | " + distance_str + " | " +
                std::to_string(discovery_time) + " | " + std::to_string(closing_time) + " | " + prev_id;
@@ -114,237 +328,3764 @@ public:
 };
 
 // Overloads the << operator to provide a standard way of outputting vertex details.
+// Neighbors are printed by index; Graph's << operator prints them by identifier.
 ostream &operator<<(ostream &stream, Vertex &vert) {
-    vector<string> connects = vert.getConnections();
+    vector<uint32_t> connects = vert.getConnections();
     stream << vert.id << " -> ";
     for (unsigned int i = 0; i < connects.size(); i++) {
-        stream << connects[i] << " (Weight: " << vert.getWeight(connects[i]) << ")" << endl;
+        stream << "#" << connects[i] << " (Weight: " << vert.getWeight(connects[i]) << ")" << endl;
         if (i < connects.size() - 1) stream << "\t";
     }
     return stream;
 }
 
 /**
- * Represents a graph structure with a list of vertices and methods to manipulate the graph,
- * such as adding vertices and edges, and checking if a vertex exists.
- * 
+ * Result of an unweighted traversal over a CsrGraph: the hop count from the source and the
+ * previous vertex on a shortest path, both indexed by dense vertex id.
+ *
  * Attributes:
- *     vertList (map<string, Vertex>): Maps vertex identifiers to Vertex objects.
- *     numVertices (int): Number of vertices in the graph.
- *     directional (bool): Flag to check if the graph is directed.
+ *     distance (vector<int>): Hop count from the source, numeric_limits<int>::max() if unreachable.
+ *     previous (vector<uint32_t>): Previous vertex on the path, NO_VERTEX for the source and unreachable vertices.
  */
-class Graph {
-public:
-    map<string, Vertex> vertList;
-    int numVertices;
-    bool directional;
+struct BfsResult {
+    vector<int> distance;
+    vector<uint32_t> previous;
+};
+
+/**
+ * Result of a weighted shortest-path search over a CsrGraph, indexed by dense vertex id.
+ *
+ * Attributes:
+ *     distance (vector<float>): Path cost from the source, infinity if unreachable.
+ *     previous (vector<uint32_t>): Previous vertex on the path, NO_VERTEX for the source and unreachable vertices.
+ */
+struct ShortestPaths {
+    vector<float> distance;
+    vector<uint32_t> previous;
+};
 
+/**
+ * Fixed set of worker threads that run parallelFor loops without starting new threads for every
+ * loop, for algorithms that execute many short parallel phases. The calling thread takes part in
+ * every loop as thread index 0, so a pool of size n starts n - 1 workers.
+ */
+class ThreadPool {
+public:
     /**
-     * Constructor initializes an empty graph, optionally directed.
-     * 
+     * Constructor starts the workers.
+     *
      * Args:
-     *     directed (bool): Specifies whether the graph is directed, default is true.
+     *     numThreads (unsigned): Total number of threads including the caller, 0 for defaultThreadCount().
      */
-    Graph(bool directed = true) : directional(directed), numVertices(0) {}
+    ThreadPool(unsigned numThreads = 0)
+        : numThreads(numThreads == 0 ? defaultThreadCount() : numThreads), jobSize(0), generation(0),
+          pending(0), stopping(false) {
+        for (unsigned t = 1; t < this->numThreads; t++) {
+            workers.emplace_back(&ThreadPool::workerLoop, this, t);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> lock(m);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
 
     /**
-     * Adds a vertex to the graph by key, initializing it if it doesn't exist.
-     * 
-     * Args:
-     *     key (string): The unique identifier for the new vertex.
-     * 
-     * Returns:
-     *     Vertex: The vertex added to the graph.
+     * Returns the number of threads that take part in a loop, including the caller.
      */
-    Vertex addVertex(string key) {
-        if (!contains(key)) {
-            numVertices++;
-            Vertex newVertex(key);
-            vertList[key] = newVertex;
-        }
-        return vertList[key];
+    unsigned size() const {
+        return numThreads;
     }
 
     /**
-     * Returns a pointer to the vertex if it exists, otherwise nullptr.
-     * 
-     * Args:
-     *     n (string): The identifier of the vertex to retrieve.
-     * 
-     * Returns:
-     *     Vertex*: A pointer to the vertex, or nullptr if it does not exist.
+     * Same contract as the free parallelFor: splits [0, n) into one chunk per thread and calls
+     * body(begin, end, threadIndex) for every non-empty chunk. Returns when all chunks are done.
      */
-    Vertex* getVertex(const string& n) {
-        auto it = vertList.find(n);
-        if (it != vertList.end()) {
-            return &it->second;
+    template<typename Function>
+    void parallelFor(size_t n, Function body) {
+        if (n == 0) {
+            return;
+        }
+        function<void(size_t, size_t, unsigned)> task = [&body](size_t begin, size_t end, unsigned t) {
+            body(begin, end, t);
+        };
+        {
+            lock_guard<mutex> lock(m);
+            job = &task;
+            jobSize = n;
+            pending = numThreads - 1;
+            generation++;
+        }
+        wake.notify_all();
+        runChunk(0);
+        unique_lock<mutex> lock(m);
+        done.wait(lock, [this] { return pending == 0; });
+        job = nullptr;
+    }
+
+private:
+    unsigned numThreads;
+    vector<thread> workers;
+    mutex m;
+    condition_variable wake;
+    condition_variable done;
+    function<void(size_t, size_t, unsigned)>* job;
+    size_t jobSize;
+    unsigned generation;
+    unsigned pending;
+    bool stopping;
+
+    void runChunk(unsigned t) {
+        size_t chunk = (jobSize + numThreads - 1) / numThreads;
+        size_t begin = min(jobSize, t * chunk);
+        size_t end = min(jobSize, begin + chunk);
+        if (begin < end) {
+            (*job)(begin, end, t);
         }
-        return nullptr;
     }
 
+    void workerLoop(unsigned t) {
+        unsigned seen = 0;
+        while (true) {
+            {
+                unique_lock<mutex> lock(m);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+            }
+            runChunk(t);
+            {
+                lock_guard<mutex> lock(m);
+                pending--;
+            }
+            done.notify_one();
+        }
+    }
+};
+
+/**
+ * Binary min-heap of dense vertex ids keyed by float priority. A position array maps every id to
+ * its slot in the heap, so contains is O(1) and decreaseKey is O(log n) instead of the linear scan
+ * of PriorityQueue::changePriority. Ids must be smaller than the capacity given to the constructor.
+ *
+ * Attributes:
+ *     heapvector (vector<pair<float, uint32_t>>): The (priority, id) pairs in heap order.
+ *     position (vector<uint32_t>): Slot of every id in heapvector, NO_VERTEX if the id is not in the heap.
+ */
+class IndexedMinHeap {
+public:
     /**
-     * Checks if a vertex with a specified identifier exists in the graph.
-     * 
+     * Constructor initializes an empty heap for ids 0..capacity-1.
+     *
      * Args:
-     *     n (string): The identifier of the vertex to check.
-     * 
-     * Returns:
-     *     bool: True if the vertex exists, false otherwise.
+     *     capacity (size_t): One more than the largest id that will be inserted.
      */
-    bool contains(string n) {
-        return vertList.find(n) != vertList.end();
+    IndexedMinHeap(size_t capacity = 0) : position(capacity, NO_VERTEX) {}
+
+    bool isEmpty() const {
+        return heapvector.empty();
+    }
+
+    size_t size() const {
+        return heapvector.size();
     }
 
+    bool contains(uint32_t item) const {
+        return position[item] != NO_VERTEX;
+    }
 
     /**
-     * Adds an edge between two vertices with an optional cost. If the vertices do not exist,
-     * they are added to the graph.
-     * 
-     * Args:
-     *     f (string): The identifier of the from vertex.
-     *     t (string): The identifier of the to vertex.
-     *     cost (float): The cost of the edge, defaulting to 1.0.
+     * Adds an id that is not yet in the heap.
+     */
+    void insert(uint32_t item, float priority) {
+        position[item] = heapvector.size();
+        heapvector.push_back(make_pair(priority, item));
+        percUp(heapvector.size() - 1);
+    }
+
+    /**
+     * Lowers the priority of an id that is already in the heap.
+     */
+    void decreaseKey(uint32_t item, float priority) {
+        size_t i = position[item];
+        heapvector[i].first = priority;
+        percUp(i);
+    }
+
+    /**
+     * Inserts the id, or lowers its priority if it is already in the heap.
      */
-    void addEdge(string f, string t, float cost = 1) {
-        if (!contains(f)) {
-            addVertex(f);
+    void insertOrDecrease(uint32_t item, float priority) {
+        if (contains(item)) {
+            decreaseKey(item, priority);
+        } else {
+            insert(item, priority);
         }
-        if (!contains(t)) {
-            addVertex(t);
+    }
+
+    /**
+     * Removes and returns the (priority, id) pair with the smallest priority.
+     *
+     * Throws:
+     *     underflow_error: If the heap is empty.
+     */
+    pair<float, uint32_t> delMin() {
+        if (isEmpty()) {
+            throw std::underflow_error("Heap is empty");
         }
-        vertList[f].addNeighbor(t, cost);
-        if (!directional) {
-            vertList[t].addNeighbor(f, cost); // Add the edge in the opposite direction for undirected graphs.
+        pair<float, uint32_t> minItem = heapvector[0];
+        position[minItem.second] = NO_VERTEX;
+        heapvector[0] = heapvector.back();
+        heapvector.pop_back();
+        if (!isEmpty()) {
+            position[heapvector[0].second] = 0;
+            percDown(0);
         }
+        return minItem;
     }
 
     /**
-     * Retrieves a list of all vertex identifiers in the graph.
-     * 
-     * Returns:
-     *     vector<string>: A vector containing all vertex identifiers in the graph.
+     * Raises the capacity so that ids up to capacity-1 can be inserted. Never shrinks the heap.
      */
-    vector<string> getVertices() {
-        vector<string> verts;
-        for (auto& pair : vertList) {
-            verts.push_back(pair.first);
+    void grow(size_t capacity) {
+        if (capacity > position.size()) {
+            position.resize(capacity, NO_VERTEX);
         }
-        return verts;
     }
 
     /**
-     * Overloads the output stream operator to print all vertices and their connections in the graph.
-     * Each vertex is printed followed by its connections and weights.
-     * 
-     * Args:
-     *     stream (ostream&): The output stream.
-     *     grph (Graph&): The graph to be printed.
-     * 
-     * Returns:
-     *     ostream&: The output stream for chaining.
+     * Removes every remaining id. The cost is proportional to the number of ids left in the heap.
      */
-    friend ostream &operator<<(ostream &stream, Graph &grph) {
-        for (auto& pair : grph.vertList) {
-            stream << grph.vertList[pair.first];
-            cout << endl;
+    void clear() {
+        for (auto& item : heapvector) {
+            position[item.second] = NO_VERTEX;
         }
-        return stream;
+        heapvector.clear();
+    }
+
+private:
+    vector<pair<float, uint32_t>> heapvector;
+    vector<uint32_t> position;
+
+    void percUp(size_t i) {
+        pair<float, uint32_t> item = heapvector[i];
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (!(item.first < heapvector[parent].first)) {
+                break;
+            }
+            heapvector[i] = heapvector[parent];
+            position[heapvector[i].second] = i;
+            i = parent;
+        }
+        heapvector[i] = item;
+        position[item.second] = i;
+    }
+
+    void percDown(size_t i) {
+        pair<float, uint32_t> item = heapvector[i];
+        while (2 * i + 1 < heapvector.size()) {
+            size_t mc = minChild(i);
+            if (!(heapvector[mc].first < item.first)) {
+                break;
+            }
+            heapvector[i] = heapvector[mc];
+            position[heapvector[i].second] = i;
+            i = mc;
+        }
+        heapvector[i] = item;
+        position[item.second] = i;
+    }
+
+    size_t minChild(size_t i) const {
+        size_t left = 2 * i + 1;
+        if (left + 1 >= heapvector.size()) {
+            return left;
+        }
+        return heapvector[left].first < heapvector[left + 1].first ? left : left + 1;
     }
 };
 
 /**
- * Constructs a graph from a list of words by connecting words that differ by one letter.
- * Each word is modified by replacing each letter sequentially with a blank, grouping words
- * by these blanked forms, and then connecting words in the same group.
- * 
+ * Breadth-first search over any graph with the CSR layout of CsrGraph: numVertices(), and offsets
+ * and targets arrays. Used by CsrGraph::bfs and MappedGraph::bfs.
+ *
  * Args:
- *     words (vector<string>): The list of words to be processed.
- * 
+ *     graph (const Csr&): The graph to search.
+ *     source (uint32_t): The dense id of the start vertex.
+ *
  * Returns:
- *     Graph: A graph where each word is a vertex and edges connect words differing by one letter.
+ *     BfsResult: Distance and previous vertex for every dense id.
  */
-Graph buildGraph(vector<string> words) {
-    Graph g(false); // Build an undirected graph
-
-    map<string, vector<string>> d; // Dictionary to group words by their blanked forms
-
-    // Iterate through each word
-    for (size_t i = 0; i < words.size(); i++) {
-        // Modify each letter in the word to create a blanked form and group by these forms
-        for (size_t j = 0; j < words[i].length(); j++) {
-            string bucket = getBlank(words[i], j);
-            d[bucket].push_back(words[i]);
-        }
-    }
+template<typename Csr>
+BfsResult breadthFirstSearch(const Csr& graph, uint32_t source) {
+    BfsResult result;
+    result.distance.assign(graph.numVertices(), numeric_limits<int>::max());
+    result.previous.assign(graph.numVertices(), NO_VERTEX);
 
-    // Connect all words in the same group with an edge
-    for (auto& pair : d) {
-        vector<string>& group = pair.second;
-        for (size_t i = 0; i < group.size(); i++) {
-            for (size_t j = i + 1; j < group.size(); j++) {
-                g.addEdge(group[i], group[j]);
+    vector<uint32_t> frontier;  // Used as a FIFO queue; head advances instead of popping.
+    frontier.reserve(graph.numVertices());
+    frontier.push_back(source);
+    result.distance[source] = 0;
+    for (size_t head = 0; head < frontier.size(); head++) {
+        uint32_t v = frontier[head];
+        for (size_t e = graph.offsets[v]; e < graph.offsets[v + 1]; e++) {
+            uint32_t w = graph.targets[e];
+            if (result.distance[w] == numeric_limits<int>::max()) {
+                result.distance[w] = result.distance[v] + 1;
+                result.previous[w] = v;
+                frontier.push_back(w);
             }
         }
     }
-
-    return g;
+    return result;
 }
 
 /**
- * Helper function to replace a specific character in a string with an underscore,
- * used to generate blanked forms of words.
- * 
+ * Inverts a vertex order as returned by the reordering functions: order[i] is the old id of the
+ * vertex that moves to position i, and the result maps every old id to its new position.
+ *
  * Args:
- *     str (string): The original string.
- *     index (int): The position of the character to be replaced.
- * 
+ *     order (vector<uint32_t>): A permutation of 0..n-1.
+ *
  * Returns:
- *     string: The modified string with the specified character replaced by an underscore.
+ *     vector<uint32_t>: The new id of every old id.
+ *
+ * Throws:
+ *     invalid_argument: If order is not a permutation.
  */
-string getBlank(string str, int index) {
-    string blank = str;
-    blank[index] = '_';
-    return blank;
+vector<uint32_t> inversePermutation(const vector<uint32_t>& order) {
+    vector<uint32_t> position(order.size(), NO_VERTEX);
+    for (size_t i = 0; i < order.size(); i++) {
+        if (order[i] >= order.size() || position[order[i]] != NO_VERTEX) {
+            throw std::invalid_argument("Vertex order is not a permutation");
+        }
+        position[order[i]] = static_cast<uint32_t>(i);
+    }
+    return position;
 }
 
-
 /**
- * Class representing a depth-first search (DFS) specific graph structure. It maintains a map
- * of vertex identifiers to vertices, where each vertex has a list of connected vertices.
- * This class is tailored for performing depth-first searches, especially in directed or
- * undirected graphs.
- * 
+ * Immutable compressed sparse row (CSR) snapshot of a graph. Vertices are renumbered with dense
+ * integer ids 0..n-1 and the outgoing edges of vertex v are stored contiguously in
+ * targets[offsets[v]] .. targets[offsets[v + 1] - 1], with the matching weights alongside.
+ * Neighbor hops are array reads instead of string-keyed map lookups, which makes the snapshot
+ * the preferred representation for read-heavy traversal workloads.
+ *
+ * A CsrGraph is produced by Graph::freeze() or DFSGraph::freeze(); it is not modified afterwards.
+ *
  * Attributes:
- *     vertices (graph_t): A map from vertex identifiers to vertex structures containing
- *                          vertex data and adjacency lists.
- *     directional (bool): Indicates whether the graph is directed or not.
+ *     keys (KeyInterner): Maps original vertex identifiers to dense ids and back.
+ *     offsets (vector<size_t>): Start of each vertex's edge range, with one extra entry at the end.
+ *     targets (vector<uint32_t>): Dense id of the head of every edge.
+ *     weights (vector<float>): Weight of every edge, parallel to targets.
+ *     directional (bool): Whether the source graph was directed. Undirected graphs store both directions.
  */
-class DFSGraph{
-    typedef std::pair<int, std::list<int>> vertex_t;  // Pair containing vertex identifier and list of neighbors.
-    typedef std::map<int, vertex_t> graph_t;  // Type alias for the graph data structure.
-
+class CsrGraph {
 public:
-    const bool directional;  // Flag to indicate if the graph is directed.
+    KeyInterner keys;
+    vector<size_t> offsets;
+    vector<uint32_t> targets;
+    vector<float> weights;
+    bool directional;
 
     /**
-     * Constructor for DFSGraph that initializes it as either directed or undirected.
-     * 
+     * Constructor initializes an empty snapshot, optionally directed.
+     *
      * Args:
-     *     directional (bool): Specifies whether the graph is directed.
+     *     directed (bool): Specifies whether the graph is directed, default is true.
      */
-    DFSGraph(bool directional) : directional(directional) {}
+    CsrGraph(bool directed = true) : offsets(1, 0), directional(directed) {}
 
     /**
-     * Checks if a vertex with the given identifier exists in the graph.
-     * 
-     * Args:
-     *     id (int): The identifier of the vertex to check.
-     * 
-     * Returns:
-     *     bool: True if the vertex exists, false otherwise.
+     * Returns the number of vertices in the snapshot.
      */
-    bool containsVertex(int id) {
-        return vertices.count(id) > 0;
+    size_t numVertices() const {
+        return keys.size();
+    }
+
+    /**
+     * Returns the number of stored edges. Undirected edges are counted once per direction.
+     */
+    size_t numEdges() const {
+        return targets.size();
+    }
+
+    /**
+     * Returns the dense id of a vertex.
+     *
+     * Args:
+     *     key (string): The original identifier of the vertex.
+     *
+     * Returns:
+     *     uint32_t: The dense id, or NO_VERTEX if the vertex does not exist.
+     */
+    uint32_t indexOf(const string& key) const {
+        return keys.find(key);
+    }
+
+    /**
+     * Returns the number of outgoing edges of a vertex.
+     *
+     * Args:
+     *     v (uint32_t): The dense id of the vertex.
+     */
+    size_t degree(uint32_t v) const {
+        return offsets[v + 1] - offsets[v];
+    }
+
+    /**
+     * Calls visit(w) for the head w of every outgoing edge of v.
+     *
+     * Args:
+     *     v (uint32_t): The dense id of the vertex.
+     *     visit (Function): Called with the dense id of each neighbor.
+     */
+    template<typename Function>
+    void forEachNeighbor(uint32_t v, Function visit) const {
+        for (size_t e = offsets[v]; e < offsets[v + 1]; e++) {
+            visit(targets[e]);
+        }
+    }
+
+    /**
+     * Builds the snapshot with every edge reversed, i.e. the incoming adjacency of this graph.
+     *
+     * Returns:
+     *     CsrGraph: The transposed graph, with the same dense ids.
+     */
+    CsrGraph transpose() const {
+        CsrGraph result(directional);
+        result.keys = keys;
+        result.offsets.assign(numVertices() + 1, 0);
+        for (uint32_t w : targets) {
+            result.offsets[w + 1]++;
+        }
+        for (size_t v = 0; v < numVertices(); v++) {
+            result.offsets[v + 1] += result.offsets[v];
+        }
+        result.targets.resize(numEdges());
+        result.weights.resize(numEdges());
+        vector<size_t> next(result.offsets.begin(), result.offsets.end() - 1);
+        for (uint32_t v = 0; v < numVertices(); v++) {
+            for (size_t e = offsets[v]; e < offsets[v + 1]; e++) {
+                size_t slot = next[targets[e]]++;
+                result.targets[slot] = v;
+                result.weights[slot] = weights[e];
+            }
+        }
+        return result;
+    }
+
+    /**
+     * Builds a copy of the snapshot with the vertices renumbered, e.g. by reverseCuthillMcKeeOrder,
+     * so that vertices visited together are stored together. Keys move with their vertices and
+     * every neighbor list is sorted by new id.
+     *
+     * Args:
+     *     order (vector<uint32_t>): order[i] is the old id of the vertex that gets id i.
+     *
+     * Returns:
+     *     CsrGraph: The renumbered snapshot.
+     *
+     * Throws:
+     *     invalid_argument: If order is not a permutation of the vertex ids.
+     */
+    CsrGraph permute(const vector<uint32_t>& order) const {
+        if (order.size() != numVertices()) {
+            throw std::invalid_argument("Vertex order is not a permutation");
+        }
+        vector<uint32_t> position = inversePermutation(order);
+        CsrGraph result(directional);
+        if (keys.size() == numVertices()) {
+            result.keys.reserve(numVertices());
+            for (uint32_t old : order) {
+                result.keys.intern(keys.name(old));
+            }
+        }
+        result.offsets.reserve(numVertices() + 1);
+        result.targets.reserve(numEdges());
+        result.weights.reserve(numEdges());
+        vector<pair<uint32_t, float>> adjacent;
+        for (uint32_t old : order) {
+            adjacent.clear();
+            for (size_t e = offsets[old]; e < offsets[old + 1]; e++) {
+                adjacent.push_back(make_pair(position[targets[e]], weights[e]));
+            }
+            sort(adjacent.begin(), adjacent.end());
+            for (auto& edge : adjacent) {
+                result.targets.push_back(edge.first);
+                result.weights.push_back(edge.second);
+            }
+            result.offsets.push_back(result.targets.size());
+        }
+        return result;
+    }
+
+    /**
+     * Performs a breadth-first search from the source, recording hop counts and the BFS tree.
+     * See parallelBfs for the multithreaded variant.
+     *
+     * Args:
+     *     source (uint32_t): The dense id of the start vertex.
+     *
+     * Returns:
+     *     BfsResult: Distance and previous vertex for every dense id.
+     */
+    BfsResult bfs(uint32_t source) const {
+        return breadthFirstSearch(*this, source);
+    }
+
+    /**
+     * Performs a depth-first search from the source without recursion.
+     *
+     * Args:
+     *     source (uint32_t): The dense id of the start vertex.
+     *
+     * Returns:
+     *     vector<uint32_t>: Dense ids of the reachable vertices in discovery order.
+     */
+    vector<uint32_t> dfs(uint32_t source) const {
+        vector<uint32_t> order;
+        vector<bool> visited(numVertices(), false);
+        vector<pair<uint32_t, size_t>> stack;  // (vertex, next edge to examine)
+
+        visited[source] = true;
+        order.push_back(source);
+        stack.push_back(make_pair(source, offsets[source]));
+        while (!stack.empty()) {
+            uint32_t v = stack.back().first;
+            size_t& e = stack.back().second;
+            if (e == offsets[v + 1]) {
+                stack.pop_back();
+                continue;
+            }
+            uint32_t w = targets[e++];
+            if (!visited[w]) {
+                visited[w] = true;
+                order.push_back(w);
+                stack.push_back(make_pair(w, offsets[w]));
+            }
+        }
+        return order;
+    }
+
+    /**
+     * Computes single-source shortest paths with Dijkstra's algorithm. Edge weights must be non-negative.
+     * See DijkstraSearch for point-to-point and multi-source queries.
+     *
+     * Args:
+     *     source (uint32_t): The dense id of the start vertex.
+     *
+     * Returns:
+     *     ShortestPaths: Path cost and previous vertex for every dense id.
+     */
+    ShortestPaths dijkstra(uint32_t source) const;
+};
+
+/**
+ * Reusable Dijkstra shortest-path search over a CsrGraph, or any graph with the same CSR layout
+ * such as MappedGraph, driven by an IndexedMinHeap. The distance
+ * and previous arrays are allocated once; between queries only the entries touched by the previous
+ * query are reset, so repeated short point-to-point queries do not pay for the whole graph.
+ * Edge weights must be non-negative.
+ *
+ * Attributes:
+ *     settled (size_t): Number of vertices removed from the heap by the last query.
+ */
+template<typename Csr = CsrGraph>
+class DijkstraSearch {
+public:
+    size_t settled;
+
+    /**
+     * Constructor prepares the scratch arrays for the given graph. The graph must outlive the search.
+     *
+     * Args:
+     *     graph (const Csr&): The graph to search.
+     */
+    DijkstraSearch(const Csr& graph)
+        : settled(0), graph(graph), heap(graph.numVertices()),
+          dist(graph.numVertices(), numeric_limits<float>::infinity()),
+          prev(graph.numVertices(), NO_VERTEX) {}
+
+    /**
+     * Runs a query from one or more sources, each at distance 0, so every vertex ends up with its
+     * distance to the nearest source. With a target the search stops as soon as the target is
+     * settled; distances of vertices that were not settled are then upper bounds.
+     *
+     * Args:
+     *     sources (vector<uint32_t>): Dense ids of the start vertices.
+     *     target (uint32_t): Dense id of the destination, or NO_VERTEX to search the whole graph.
+     */
+    void run(const vector<uint32_t>& sources, uint32_t target = NO_VERTEX) {
+        reset();
+        for (uint32_t s : sources) {
+            if (dist[s] != 0) {
+                touched.push_back(s);
+                dist[s] = 0;
+                heap.insert(s, 0);
+            }
+        }
+        while (!heap.isEmpty()) {
+            pair<float, uint32_t> top = heap.delMin();
+            uint32_t v = top.second;
+            settled++;
+            if (v == target) {
+                break;
+            }
+            for (size_t e = graph.offsets[v]; e < graph.offsets[v + 1]; e++) {
+                uint32_t w = graph.targets[e];
+                float newDistance = top.first + graph.weights[e];
+                if (newDistance < dist[w]) {
+                    if (dist[w] == numeric_limits<float>::infinity()) {
+                        touched.push_back(w);
+                    }
+                    dist[w] = newDistance;
+                    prev[w] = v;
+                    heap.insertOrDecrease(w, newDistance);
+                }
+            }
+        }
+    }
+
+    /**
+     * Returns the cost of the shortest path found to v, infinity if v was not reached.
+     */
+    float distance(uint32_t v) const {
+        return dist[v];
+    }
+
+    /**
+     * Returns the previous vertex on the shortest path to v, NO_VERTEX for sources and unreached vertices.
+     */
+    uint32_t previous(uint32_t v) const {
+        return prev[v];
+    }
+
+    /**
+     * Returns the vertices on the shortest path from a source to the target, both included.
+     *
+     * Args:
+     *     target (uint32_t): The dense id of the destination.
+     *
+     * Returns:
+     *     vector<uint32_t>: The path in source-to-target order, empty if the target was not reached.
+     */
+    vector<uint32_t> pathTo(uint32_t target) const {
+        vector<uint32_t> path;
+        if (dist[target] == numeric_limits<float>::infinity()) {
+            return path;
+        }
+        for (uint32_t v = target; v != NO_VERTEX; v = prev[v]) {
+            path.push_back(v);
+        }
+        reverse(path.begin(), path.end());
+        return path;
+    }
+
+    /**
+     * Copies the distances and previous vertices of the last query.
+     */
+    ShortestPaths result() const {
+        ShortestPaths paths;
+        paths.distance = dist;
+        paths.previous = prev;
+        return paths;
+    }
+
+private:
+    const Csr& graph;
+    IndexedMinHeap heap;
+    vector<float> dist;
+    vector<uint32_t> prev;
+    vector<uint32_t> touched;  // Vertices whose dist/prev differ from the initial values.
+
+    void reset() {
+        for (uint32_t v : touched) {
+            dist[v] = numeric_limits<float>::infinity();
+            prev[v] = NO_VERTEX;
+        }
+        touched.clear();
+        heap.clear();
+        settled = 0;
+    }
+};
+
+ShortestPaths CsrGraph::dijkstra(uint32_t source) const {
+    DijkstraSearch search(*this);
+    search.run(vector<uint32_t>(1, source));
+    return search.result();
+}
+
+/**
+ * Runs an independent single-source Dijkstra query from every source, spread over several threads.
+ * Each thread reuses one DijkstraSearch for all of its queries.
+ *
+ * Args:
+ *     graph (const CsrGraph&): The graph to search.
+ *     sources (vector<uint32_t>): Dense ids of the start vertices, one query each.
+ *     numThreads (unsigned): Number of threads, 0 for defaultThreadCount().
+ *
+ * Returns:
+ *     vector<ShortestPaths>: The result of every query, in the order of sources.
+ */
+vector<ShortestPaths> dijkstraBatch(const CsrGraph& graph, const vector<uint32_t>& sources,
+                                    unsigned numThreads = 0) {
+    if (numThreads == 0) {
+        numThreads = defaultThreadCount();
+    }
+    vector<ShortestPaths> results(sources.size());
+    parallelFor(sources.size(), numThreads, [&](size_t begin, size_t end, unsigned) {
+        DijkstraSearch search(graph);
+        for (size_t i = begin; i < end; i++) {
+            search.run(vector<uint32_t>(1, sources[i]));
+            results[i] = search.result();
+        }
+    });
+    return results;
+}
+
+// Packs a tentative distance and the vertex it was reached from into one word, so both can be
+// updated together with a single compare-and-swap by the parallel shortest-path algorithms.
+uint64_t packDistance(float distance, uint32_t from) {
+    uint32_t bits;
+    memcpy(&bits, &distance, sizeof(bits));
+    return (uint64_t(bits) << 32) | from;
+}
+
+float unpackDistance(uint64_t packed) {
+    uint32_t bits = static_cast<uint32_t>(packed >> 32);
+    float distance;
+    memcpy(&distance, &bits, sizeof(distance));
+    return distance;
+}
+
+// Atomically lowers the distance in slot to newDistance. Returns true if this call lowered it.
+bool relaxMin(atomic<uint64_t>& slot, float newDistance, uint32_t from) {
+    uint64_t old = slot.load(memory_order_relaxed);
+    while (newDistance < unpackDistance(old)) {
+        if (slot.compare_exchange_weak(old, packDistance(newDistance, from), memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Converts the packed per-vertex state of the parallel shortest-path algorithms to ShortestPaths.
+ShortestPaths unpackShortestPaths(const vector<atomic<uint64_t>>& state) {
+    ShortestPaths result;
+    result.distance.resize(state.size());
+    result.previous.resize(state.size());
+    for (size_t v = 0; v < state.size(); v++) {
+        uint64_t packed = state[v].load(memory_order_relaxed);
+        result.distance[v] = unpackDistance(packed);
+        result.previous[v] = static_cast<uint32_t>(packed);
+    }
+    return result;
+}
+
+/**
+ * Parallel Bellman-Ford single-source shortest paths. Every round relaxes the out-edges of all
+ * reached vertices in parallel, and rounds stop early once nothing changes. Negative edge weights
+ * are allowed.
+ *
+ * Args:
+ *     graph (const CsrGraph&): The graph to search.
+ *     source (uint32_t): The dense id of the start vertex.
+ *     numThreads (unsigned): Number of threads, 0 for defaultThreadCount().
+ *
+ * Returns:
+ *     ShortestPaths: Path cost and previous vertex for every dense id.
+ *
+ * Throws:
+ *     runtime_error: If a negative-weight cycle is reachable from the source.
+ */
+ShortestPaths bellmanFord(const CsrGraph& graph, uint32_t source, unsigned numThreads = 0) {
+    size_t n = graph.numVertices();
+    vector<atomic<uint64_t>> state(n);
+    for (auto& slot : state) {
+        slot.store(packDistance(numeric_limits<float>::infinity(), NO_VERTEX), memory_order_relaxed);
+    }
+    state[source].store(packDistance(0, NO_VERTEX), memory_order_relaxed);
+
+    ThreadPool pool(numThreads);
+    // Without a negative cycle all distances are final after n - 1 rounds, so a change in round n means a cycle.
+    for (size_t round = 0; round < n; round++) {
+        atomic<bool> changed(false);
+        pool.parallelFor(n, [&](size_t begin, size_t end, unsigned) {
+            bool local = false;
+            for (size_t v = begin; v < end; v++) {
+                float dv = unpackDistance(state[v].load(memory_order_relaxed));
+                if (dv == numeric_limits<float>::infinity()) {
+                    continue;
+                }
+                for (size_t e = graph.offsets[v]; e < graph.offsets[v + 1]; e++) {
+                    local |= relaxMin(state[graph.targets[e]], dv + graph.weights[e], static_cast<uint32_t>(v));
+                }
+            }
+            if (local) {
+                changed.store(true, memory_order_relaxed);
+            }
+        });
+        if (!changed.load()) {
+            return unpackShortestPaths(state);
+        }
+    }
+    throw std::runtime_error("Graph contains a negative-weight cycle");
+}
+
+/**
+ * Parallel delta-stepping single-source shortest paths (Meyer and Sanders). Tentative distances are
+ * grouped into buckets of width delta and buckets are settled in increasing order; all vertices of
+ * the current bucket are relaxed in parallel on a thread pool, and vertices whose distance drops are
+ * put into thread-local buckets that are merged before the next phase. A small delta approaches
+ * Dijkstra's work with little parallelism; a large delta approaches Bellman-Ford.
+ *
+ * The buckets are kept sparse, as an ordered map from bucket index to vertices, so memory follows
+ * the number of queued vertices rather than the largest distance divided by delta; a heavy edge or
+ * a tiny delta only makes the indices large. Infinite and overflowing distances share the last bucket.
+ *
+ * If any edge weight is negative the bucket order is no longer valid, and the call falls back to
+ * bellmanFord, which also detects negative-weight cycles.
+ *
+ * Args:
+ *     graph (const CsrGraph&): The graph to search.
+ *     source (uint32_t): The dense id of the start vertex.
+ *     delta (float): Bucket width; 0, less or NaN picks the average edge weight.
+ *     numThreads (unsigned): Number of threads, 0 for defaultThreadCount().
+ *
+ * Returns:
+ *     ShortestPaths: Path cost and previous vertex for every dense id.
+ *
+ * Throws:
+ *     runtime_error: If the graph has negative weights and a negative-weight cycle is reachable from the source.
+ */
+ShortestPaths deltaStepping(const CsrGraph& graph, uint32_t source, float delta = 0, unsigned numThreads = 0) {
+    double total = 0;
+    for (float w : graph.weights) {
+        if (w < 0) {
+            return bellmanFord(graph, source, numThreads);
+        }
+        total += w;
+    }
+    if (!(delta > 0)) {
+        delta = (graph.numEdges() == 0 || total == 0) ? 1.0f : static_cast<float>(total / graph.numEdges());
+    }
+    const uint64_t LAST_BUCKET = uint64_t(1) << 62;
+    auto bucketOf = [delta, LAST_BUCKET](float distance) {
+        double index = static_cast<double>(distance) / delta;
+        return index < LAST_BUCKET ? static_cast<uint64_t>(index) : LAST_BUCKET;  // Also for inf and NaN.
+    };
+
+    size_t n = graph.numVertices();
+    vector<atomic<uint64_t>> state(n);
+    for (auto& slot : state) {
+        slot.store(packDistance(numeric_limits<float>::infinity(), NO_VERTEX), memory_order_relaxed);
+    }
+    state[source].store(packDistance(0, NO_VERTEX), memory_order_relaxed);
+
+    ThreadPool pool(numThreads);
+    vector<map<uint64_t, vector<uint32_t>>> localBuckets(pool.size());
+    vector<uint32_t> frontier(1, source);
+    uint64_t bucket = 0;
+    while (true) {
+        float lower = delta * bucket;
+        pool.parallelFor(frontier.size(), [&](size_t begin, size_t end, unsigned t) {
+            map<uint64_t, vector<uint32_t>>& buckets = localBuckets[t];
+            for (size_t i = begin; i < end; i++) {
+                uint32_t v = frontier[i];
+                float dv = unpackDistance(state[v].load(memory_order_relaxed));
+                if (dv < lower) {
+                    continue;  // Already settled with an earlier bucket.
+                }
+                for (size_t e = graph.offsets[v]; e < graph.offsets[v + 1]; e++) {
+                    uint32_t w = graph.targets[e];
+                    float newDistance = dv + graph.weights[e];
+                    if (relaxMin(state[w], newDistance, v)) {
+                        buckets[max(bucket, bucketOf(newDistance))].push_back(w);
+                    }
+                }
+            }
+        });
+
+        // The next phase works on the lowest non-empty bucket, which may be the current one again.
+        bool found = false;
+        uint64_t next = 0;
+        for (auto& buckets : localBuckets) {
+            if (!buckets.empty() && (!found || buckets.begin()->first < next)) {
+                next = buckets.begin()->first;
+                found = true;
+            }
+        }
+        if (!found) {
+            break;
+        }
+        frontier.clear();
+        for (auto& buckets : localBuckets) {
+            auto it = buckets.find(next);
+            if (it != buckets.end()) {
+                frontier.insert(frontier.end(), it->second.begin(), it->second.end());
+                buckets.erase(it);
+            }
+        }
+        bucket = next;
+    }
+    return unpackShortestPaths(state);
+}
+
+/**
+ * Multithreaded level-synchronous breadth-first search that switches between top-down and
+ * bottom-up frontier expansion (direction-optimizing BFS).
+ *
+ * A top-down step scans the out-edges of the frontier and claims unvisited vertices with an atomic
+ * fetch-or on the visited bitmap. A bottom-up step lets every unvisited vertex look for a parent among
+ * its in-neighbors and stops at the first hit, which is much cheaper once the frontier covers a large
+ * part of the graph. The search goes bottom-up when the frontier's out-edges exceed 1/14 of the
+ * edges still unexplored, and back to top-down when the frontier shrinks below 1/24 of the vertices.
+ * Each thread appends discoveries to its own buffer; the buffers become the next frontier.
+ *
+ * Distances are deterministic; when a vertex has several parents on the previous level, which one is
+ * recorded depends on thread timing.
+ *
+ * Args:
+ *     graph (const CsrGraph&): The graph to search.
+ *     source (uint32_t): The dense id of the start vertex.
+ *     numThreads (unsigned): Number of threads, 0 for defaultThreadCount().
+ *     incoming (const CsrGraph*): The transpose of a directed graph, if the caller already has it.
+ *                                 It is computed on demand when null; undirected graphs never need it.
+ *
+ * Returns:
+ *     BfsResult: Distance and previous vertex for every dense id.
+ */
+BfsResult parallelBfs(const CsrGraph& graph, uint32_t source, unsigned numThreads = 0,
+                      const CsrGraph* incoming = nullptr) {
+    const size_t ALPHA = 14;
+    const size_t BETA = 24;
+    if (numThreads == 0) {
+        numThreads = defaultThreadCount();
+    }
+    CsrGraph transposed;
+    if (incoming == nullptr) {
+        if (graph.directional) {
+            transposed = graph.transpose();
+            incoming = &transposed;
+        } else {
+            incoming = &graph;
+        }
+    }
+
+    size_t n = graph.numVertices();
+    size_t words = (n + 63) / 64;
+    BfsResult result;
+    result.distance.assign(n, numeric_limits<int>::max());
+    result.previous.assign(n, NO_VERTEX);
+    vector<atomic<uint64_t>> visited(words);
+    for (auto& word : visited) {
+        word.store(0, memory_order_relaxed);
+    }
+    vector<uint64_t> frontierBits;
+    vector<vector<uint32_t>> buffers(numThreads);
+    vector<size_t> edgeCounts(numThreads);
+
+    vector<uint32_t> frontier(1, source);
+    visited[source >> 6].store(uint64_t(1) << (source & 63), memory_order_relaxed);
+    result.distance[source] = 0;
+    size_t frontierEdges = graph.degree(source);
+    size_t unexplored = graph.numEdges() - frontierEdges;
+    bool bottomUp = false;
+
+    for (int level = 1; !frontier.empty(); level++) {
+        if (!bottomUp && frontierEdges > unexplored / ALPHA) {
+            bottomUp = true;
+        } else if (bottomUp && frontier.size() < n / BETA) {
+            bottomUp = false;
+        }
+        for (unsigned t = 0; t < numThreads; t++) {
+            buffers[t].clear();
+            edgeCounts[t] = 0;
+        }
+
+        if (bottomUp) {
+            frontierBits.assign(words, 0);
+            for (uint32_t v : frontier) {
+                frontierBits[v >> 6] |= uint64_t(1) << (v & 63);
+            }
+            // Threads own whole bitmap words, so each vertex is examined by exactly one thread.
+            parallelFor(words, numThreads, [&](size_t begin, size_t end, unsigned t) {
+                for (size_t w = begin; w < end; w++) {
+                    uint64_t seen = visited[w].load(memory_order_relaxed);
+                    uint64_t found = 0;
+                    for (size_t bit = 0; bit < 64 && w * 64 + bit < n; bit++) {
+                        if ((seen >> bit) & 1) {
+                            continue;
+                        }
+                        uint32_t v = static_cast<uint32_t>(w * 64 + bit);
+                        for (size_t e = incoming->offsets[v]; e < incoming->offsets[v + 1]; e++) {
+                            uint32_t u = incoming->targets[e];
+                            if ((frontierBits[u >> 6] >> (u & 63)) & 1) {
+                                found |= uint64_t(1) << bit;
+                                result.distance[v] = level;
+                                result.previous[v] = u;
+                                buffers[t].push_back(v);
+                                edgeCounts[t] += graph.degree(v);
+                                break;
+                            }
+                        }
+                    }
+                    if (found != 0) {
+                        visited[w].fetch_or(found, memory_order_relaxed);
+                    }
+                }
+            });
+        } else {
+            parallelFor(frontier.size(), numThreads, [&](size_t begin, size_t end, unsigned t) {
+                for (size_t i = begin; i < end; i++) {
+                    uint32_t v = frontier[i];
+                    for (size_t e = graph.offsets[v]; e < graph.offsets[v + 1]; e++) {
+                        uint32_t w = graph.targets[e];
+                        uint64_t mask = uint64_t(1) << (w & 63);
+                        if (visited[w >> 6].load(memory_order_relaxed) & mask) {
+                            continue;
+                        }
+                        if (!(visited[w >> 6].fetch_or(mask, memory_order_relaxed) & mask)) {
+                            result.distance[w] = level;
+                            result.previous[w] = v;
+                            buffers[t].push_back(w);
+                            edgeCounts[t] += graph.degree(w);
+                        }
+                    }
+                }
+            });
+        }
+
+        frontier.clear();
+        frontierEdges = 0;
+        for (unsigned t = 0; t < numThreads; t++) {
+            frontier.insert(frontier.end(), buffers[t].begin(), buffers[t].end());
+            frontierEdges += edgeCounts[t];
+        }
+        unexplored -= min(unexplored, frontierEdges);
+    }
+    return result;
+}
+
+/**
+ * Reusable A* point-to-point search over a CsrGraph, or any graph with the same CSR layout. It
+ * works like DijkstraSearch but orders the heap by distance plus a heuristic estimate of the
+ * remaining distance to the target, so vertices that lead away from the target are settled late or
+ * never. Edge weights must be non-negative.
+ *
+ * The heuristic is any callable that maps a dense id to a float. It must never overestimate the
+ * remaining distance; infinity marks a vertex that cannot reach the target, which is then skipped.
+ * A vertex whose distance improves after it was settled is put back in the heap, so the result is
+ * exact even for a heuristic that is admissible but not consistent. The estimate of every vertex is
+ * computed once per query. A heuristic that always returns 0 turns the search into Dijkstra.
+ *
+ * Attributes:
+ *     settled (size_t): Number of vertices removed from the heap by the last query.
+ */
+template<typename Csr = CsrGraph>
+class AStarSearch {
+public:
+    size_t settled;
+
+    /**
+     * Constructor prepares the scratch arrays for the given graph. The graph must outlive the search.
+     *
+     * Args:
+     *     graph (const Csr&): The graph to search.
+     */
+    AStarSearch(const Csr& graph)
+        : settled(0), graph(graph), heap(graph.numVertices()),
+          dist(graph.numVertices(), numeric_limits<float>::infinity()),
+          estimate(graph.numVertices(), -1), prev(graph.numVertices(), NO_VERTEX) {}
+
+    /**
+     * Finds a shortest path from source to target.
+     *
+     * Args:
+     *     source (uint32_t): Dense id of the start vertex.
+     *     target (uint32_t): Dense id of the destination.
+     *     heuristic (Heuristic): Lower bound on the distance from a vertex to the target.
+     *
+     * Returns:
+     *     float: The cost of the shortest path, infinity if the target is unreachable.
+     */
+    template<typename Heuristic>
+    float run(uint32_t source, uint32_t target, Heuristic heuristic) {
+        reset();
+        touched.push_back(source);
+        dist[source] = 0;
+        estimate[source] = heuristic(source);
+        if (estimate[source] == numeric_limits<float>::infinity()) {
+            return numeric_limits<float>::infinity();
+        }
+        heap.insert(source, estimate[source]);
+        while (!heap.isEmpty()) {
+            uint32_t v = heap.delMin().second;
+            settled++;
+            if (v == target) {
+                break;
+            }
+            for (size_t e = graph.offsets[v]; e < graph.offsets[v + 1]; e++) {
+                uint32_t w = graph.targets[e];
+                float newDistance = dist[v] + graph.weights[e];
+                if (!(newDistance < dist[w])) {
+                    continue;
+                }
+                if (estimate[w] < 0) {
+                    touched.push_back(w);
+                    estimate[w] = heuristic(w);
+                }
+                if (estimate[w] == numeric_limits<float>::infinity()) {
+                    continue;
+                }
+                dist[w] = newDistance;
+                prev[w] = v;
+                heap.insertOrDecrease(w, newDistance + estimate[w]);
+            }
+        }
+        return dist[target];
+    }
+
+    /**
+     * Returns the cost of the best path found to v, infinity if v was not reached.
+     */
+    float distance(uint32_t v) const {
+        return dist[v];
+    }
+
+    /**
+     * Returns the previous vertex on the best path found to v, NO_VERTEX for the source and unreached vertices.
+     */
+    uint32_t previous(uint32_t v) const {
+        return prev[v];
+    }
+
+    /**
+     * Returns the vertices on the shortest path from the source to the target, both included.
+     *
+     * Args:
+     *     target (uint32_t): The dense id of the destination of the last query.
+     *
+     * Returns:
+     *     vector<uint32_t>: The path in source-to-target order, empty if the target was not reached.
+     */
+    vector<uint32_t> pathTo(uint32_t target) const {
+        vector<uint32_t> path;
+        if (dist[target] == numeric_limits<float>::infinity()) {
+            return path;
+        }
+        for (uint32_t v = target; v != NO_VERTEX; v = prev[v]) {
+            path.push_back(v);
+        }
+        reverse(path.begin(), path.end());
+        return path;
+    }
+
+private:
+    const Csr& graph;
+    IndexedMinHeap heap;
+    vector<float> dist;
+    vector<float> estimate;    // Heuristic value, -1 until computed in the current query.
+    vector<uint32_t> prev;
+    vector<uint32_t> touched;  // Vertices whose dist/estimate/prev differ from the initial values.
+
+    void reset() {
+        for (uint32_t v : touched) {
+            dist[v] = numeric_limits<float>::infinity();
+            estimate[v] = -1;
+            prev[v] = NO_VERTEX;
+        }
+        touched.clear();
+        heap.clear();
+        settled = 0;
+    }
+};
+
+/**
+ * Precomputed landmark distances for the ALT heuristic (A*, landmarks, triangle inequality). For a
+ * landmark L the triangle inequality gives two lower bounds on the distance from v to t:
+ * d(L,t) - d(L,v) and d(v,L) - d(t,L). The heuristic is the largest of these over all landmarks.
+ *
+ * Landmarks are chosen greedily: each new landmark is the vertex with the most BFS hops to its
+ * nearest landmark so far, and vertices no landmark reaches come first, so every component gets
+ * one. The distances are then computed with one Dijkstra query per landmark, run in parallel (and
+ * a second set on the transposed graph for a directed graph, where d(v,L) differs from d(L,v)).
+ * They are stored vertex-major, so evaluating the bound for a vertex reads one contiguous block of
+ * numLandmarks() floats. Edge weights must be non-negative.
+ *
+ * Usage:
+ *     LandmarkIndex alt(graph);
+ *     AStarSearch<> search(graph);
+ *     search.run(s, t, alt.towards(t));
+ */
+class LandmarkIndex {
+public:
+    /**
+     * Heuristic toward one target, for AStarSearch::run. Holds the target's own landmark distances.
+     */
+    class Bound {
+    public:
+        Bound(const LandmarkIndex& index, uint32_t target) : index(index), target(target) {}
+
+        float operator()(uint32_t v) const {
+            return index.lowerBound(v, target);
+        }
+
+    private:
+        const LandmarkIndex& index;
+        uint32_t target;
+    };
+
+    /**
+     * Constructor selects the landmarks and computes their distances.
+     *
+     * Args:
+     *     graph (const CsrGraph&): The graph queries will run on.
+     *     numLandmarks (size_t): How many landmarks to select, at most the number of vertices.
+     *     numThreads (unsigned): Number of threads, 0 for defaultThreadCount().
+     */
+    LandmarkIndex(const CsrGraph& graph, size_t numLandmarks = 16, unsigned numThreads = 0)
+        : directional(graph.directional) {
+        if (numThreads == 0) {
+            numThreads = defaultThreadCount();
+        }
+        size_t n = graph.numVertices();
+        CsrGraph incoming;
+        if (directional) {
+            incoming = graph.transpose();
+        }
+        const CsrGraph* in = directional ? &incoming : nullptr;
+
+        // Farthest-first selection by hop count; the first search only finds a starting point.
+        vector<int> nearest;
+        if (n > 0) {
+            nearest = parallelBfs(graph, 0, numThreads, in).distance;
+        }
+        while (marks.size() < min(numLandmarks, n)) {
+            uint32_t best = 0;
+            for (uint32_t v = 1; v < n; v++) {
+                if (nearest[v] > nearest[best]) {
+                    best = v;
+                }
+            }
+            if (!marks.empty() && nearest[best] == 0) {
+                break;
+            }
+            vector<int> hops = parallelBfs(graph, best, numThreads, in).distance;
+            for (size_t v = 0; v < n; v++) {
+                nearest[v] = marks.empty() ? hops[v] : min(nearest[v], hops[v]);
+            }
+            marks.push_back(best);
+        }
+
+        size_t k = marks.size();
+        fromLandmark.assign(n * k, numeric_limits<float>::infinity());
+        if (directional) {
+            toLandmark.assign(n * k, numeric_limits<float>::infinity());
+        }
+        // Queries 0..k-1 fill fromLandmark and k..2k-1 toLandmark; one column per query.
+        size_t queries = directional ? 2 * k : k;
+        parallelFor(queries, min<size_t>(numThreads, max<size_t>(queries, 1)),
+                    [&](size_t begin, size_t end, unsigned) {
+            DijkstraSearch<> forward(graph);
+            DijkstraSearch<> backward(incoming);  // Empty for an undirected graph.
+            for (size_t q = begin; q < end; q++) {
+                bool reversed = q >= k;
+                DijkstraSearch<>& search = reversed ? backward : forward;
+                vector<float>& table = reversed ? toLandmark : fromLandmark;
+                size_t column = reversed ? q - k : q;
+                search.run(vector<uint32_t>(1, marks[column]));
+                for (size_t v = 0; v < n; v++) {
+                    table[v * k + column] = search.distance(static_cast<uint32_t>(v));
+                }
+            }
+        });
+    }
+
+    size_t numLandmarks() const {
+        return marks.size();
+    }
+
+    /**
+     * Returns the dense ids of the landmarks, in the order they were selected.
+     */
+    const vector<uint32_t>& landmarks() const {
+        return marks;
+    }
+
+    /**
+     * Returns a lower bound on the distance from v to t, infinity if the landmarks prove t unreachable.
+     */
+    float lowerBound(uint32_t v, uint32_t t) const {
+        size_t k = marks.size();
+        const float* fromV = &fromLandmark[v * k];
+        const float* fromT = &fromLandmark[t * k];
+        const float* toV = directional ? &toLandmark[v * k] : fromV;
+        const float* toT = directional ? &toLandmark[t * k] : fromT;
+        float best = 0;
+        for (size_t i = 0; i < k; i++) {
+            // inf - inf is NaN and fails both comparisons: that landmark says nothing about v and t.
+            float ahead = fromT[i] - fromV[i];
+            float behind = toV[i] - toT[i];
+            if (ahead > best) {
+                best = ahead;
+            }
+            if (behind > best) {
+                best = behind;
+            }
+        }
+        return best;
+    }
+
+    /**
+     * Returns the heuristic toward target, to pass to AStarSearch::run.
+     */
+    Bound towards(uint32_t target) const {
+        return Bound(*this, target);
+    }
+
+private:
+    bool directional;
+    vector<uint32_t> marks;
+    vector<float> fromLandmark;  // fromLandmark[v * k + i] = d(landmark i, v)
+    vector<float> toLandmark;    // toLandmark[v * k + i] = d(v, landmark i), only for directed graphs.
+};
+
+/**
+ * Union-find over dense ids that can be used by many threads at once without locks. find halves
+ * paths with compare-and-swap, and unite always links the root with the larger id under the root
+ * with the smaller id, so concurrent links can never form a cycle.
+ */
+class ConcurrentUnionFind {
+public:
+    /**
+     * Constructor creates n singleton sets.
+     */
+    ConcurrentUnionFind(size_t n) : parent(n) {
+        for (size_t v = 0; v < n; v++) {
+            parent[v].store(static_cast<uint32_t>(v), memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Returns the representative of the set containing v.
+     */
+    uint32_t find(uint32_t v) {
+        while (true) {
+            uint32_t p = parent[v].load(memory_order_relaxed);
+            if (p == v) {
+                return v;
+            }
+            uint32_t gp = parent[p].load(memory_order_relaxed);
+            if (gp != p) {
+                parent[v].compare_exchange_weak(p, gp, memory_order_relaxed);
+            }
+            v = gp;
+        }
+    }
+
+    /**
+     * Merges the sets containing a and b.
+     *
+     * Returns:
+     *     bool: True if this call merged two different sets, false if they were already one set.
+     */
+    bool unite(uint32_t a, uint32_t b) {
+        while (true) {
+            a = find(a);
+            b = find(b);
+            if (a == b) {
+                return false;
+            }
+            if (a < b) {
+                swap(a, b);
+            }
+            uint32_t expected = a;
+            if (parent[a].compare_exchange_strong(expected, b, memory_order_acq_rel)) {
+                return true;
+            }
+        }
+    }
+
+private:
+    vector<atomic<uint32_t>> parent;
+};
+
+// Maps a float to an unsigned key with the same order, so weights can be compared as integers.
+uint32_t orderedWeightKey(float weight) {
+    uint32_t bits;
+    memcpy(&bits, &weight, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+/**
+ * Computes a minimum spanning forest of an undirected graph: a minimum spanning tree of every
+ * connected component.
+ *
+ * The engine runs parallel Boruvka rounds. In each round every edge between two different
+ * components offers itself to both components with an atomic minimum, every component then
+ * hooks onto its lightest edge through a lock-free union-find, and edges that became internal
+ * are dropped. Ties are broken by edge position, which makes the chosen edges cycle-free. Once
+ * fewer than KRUSKAL_THRESHOLD edges remain, the rest of the forest is finished sequentially with
+ * Kruskal's algorithm, which is faster than further rounds on a small contracted graph.
+ *
+ * Args:
+ *     graph (const CsrGraph&): An undirected graph, e.g. from Graph(false).freeze().
+ *     numThreads (unsigned): Number of threads, 0 for defaultThreadCount().
+ *
+ * Returns:
+ *     vector<Edge>: The forest edges by dense id, with from < to.
+ *
+ * Throws:
+ *     invalid_argument: If the graph is directed.
+ */
+vector<Edge> minimumSpanningForest(const CsrGraph& graph, unsigned numThreads = 0) {
+    const size_t KRUSKAL_THRESHOLD = 1 << 14;
+    if (graph.directional) {
+        throw std::invalid_argument("Minimum spanning forest requires an undirected graph");
+    }
+    if (numThreads == 0) {
+        numThreads = defaultThreadCount();
+    }
+    size_t n = graph.numVertices();
+
+    // Every undirected edge is stored in both directions; keep the copy with from < to.
+    vector<Edge> edges;
+    edges.reserve(graph.numEdges() / 2);
+    for (uint32_t v = 0; v < n; v++) {
+        for (size_t e = graph.offsets[v]; e < graph.offsets[v + 1]; e++) {
+            if (v < graph.targets[e]) {
+                edges.push_back({v, graph.targets[e], graph.weights[e]});
+            }
+        }
+    }
+
+    ConcurrentUnionFind components(n);
+    vector<Edge> forest;
+    vector<atomic<uint64_t>> lightest(n);
+    vector<vector<Edge>> chosen(numThreads);
+    vector<vector<Edge>> kept(numThreads);
+    ThreadPool pool(numThreads);
+
+    while (edges.size() >= KRUSKAL_THRESHOLD) {
+        pool.parallelFor(n, [&](size_t begin, size_t end, unsigned) {
+            for (size_t v = begin; v < end; v++) {
+                lightest[v].store(numeric_limits<uint64_t>::max(), memory_order_relaxed);
+            }
+        });
+        // Each edge offers (weight, position) to both of its components.
+        pool.parallelFor(edges.size(), [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; i++) {
+                uint32_t a = components.find(edges[i].from);
+                uint32_t b = components.find(edges[i].to);
+                if (a == b) {
+                    continue;
+                }
+                uint64_t offer = (uint64_t(orderedWeightKey(edges[i].weight)) << 32) | i;
+                for (uint32_t c : {a, b}) {
+                    uint64_t current = lightest[c].load(memory_order_relaxed);
+                    while (offer < current && !lightest[c].compare_exchange_weak(current, offer, memory_order_relaxed)) {
+                    }
+                }
+            }
+        });
+        // Every component hooks onto its lightest edge.
+        pool.parallelFor(n, [&](size_t begin, size_t end, unsigned t) {
+            chosen[t].clear();
+            for (size_t c = begin; c < end; c++) {
+                uint64_t offer = lightest[c].load(memory_order_relaxed);
+                if (offer == numeric_limits<uint64_t>::max()) {
+                    continue;
+                }
+                const Edge& edge = edges[static_cast<uint32_t>(offer)];
+                if (components.unite(edge.from, edge.to)) {
+                    chosen[t].push_back(edge);
+                }
+            }
+        });
+        size_t merged = 0;
+        for (auto& part : chosen) {
+            forest.insert(forest.end(), part.begin(), part.end());
+            merged += part.size();
+        }
+        if (merged == 0) {
+            break;
+        }
+        // Drop the edges that now lie inside one component.
+        pool.parallelFor(edges.size(), [&](size_t begin, size_t end, unsigned t) {
+            kept[t].clear();
+            for (size_t i = begin; i < end; i++) {
+                if (components.find(edges[i].from) != components.find(edges[i].to)) {
+                    kept[t].push_back(edges[i]);
+                }
+            }
+        });
+        edges.clear();
+        for (auto& part : kept) {
+            edges.insert(edges.end(), part.begin(), part.end());
+        }
+    }
+
+    // Kruskal on what is left: lightest edges first, skipping edges inside a component.
+    vector<uint32_t> order(edges.size());
+    for (size_t i = 0; i < edges.size(); i++) {
+        order[i] = static_cast<uint32_t>(i);
+    }
+    sort(order.begin(), order.end(), [&edges](uint32_t a, uint32_t b) {
+        uint32_t ka = orderedWeightKey(edges[a].weight);
+        uint32_t kb = orderedWeightKey(edges[b].weight);
+        return ka != kb ? ka < kb : a < b;
+    });
+    for (uint32_t i : order) {
+        if (components.unite(edges[i].from, edges[i].to)) {
+            forest.push_back(edges[i]);
+        }
+    }
+    return forest;
+}
+
+/**
+ * Component labeling of a graph: a compact id per vertex, indexed by dense vertex id.
+ *
+ * Attributes:
+ *     component (vector<uint32_t>): The component of every vertex, in 0..count-1.
+ *     count (uint32_t): The number of components.
+ */
+struct Components {
+    vector<uint32_t> component;
+    uint32_t count;
+};
+
+/**
+ * Finds the strongly connected components of a directed graph with Tarjan's algorithm, driven by an
+ * explicit stack instead of recursion so that long paths cannot overflow the call stack. Components
+ * are numbered in the order Tarjan completes them, which is a reverse topological order of the
+ * condensation: every edge between two components goes from a higher id to a lower one. Works on any
+ * graph with the CsrGraph layout.
+ *
+ * Args:
+ *     graph (const Csr&): The graph to analyze.
+ *
+ * Returns:
+ *     Components: The strongly connected component of every vertex.
+ */
+template<typename Csr>
+Components stronglyConnectedComponents(const Csr& graph) {
+    const uint32_t UNVISITED = NO_VERTEX;
+    size_t n = graph.numVertices();
+    Components result;
+    result.component.assign(n, NO_VERTEX);
+    result.count = 0;
+    vector<uint32_t> index(n, UNVISITED);
+    vector<uint32_t> low(n);
+    vector<uint32_t> stack;                   // Tarjan's stack of vertices in open components.
+    vector<pair<uint32_t, size_t>> callStack; // (vertex, next edge to examine)
+    uint32_t nextIndex = 0;
+
+    auto open = [&](uint32_t v) {
+        index[v] = low[v] = nextIndex++;
+        stack.push_back(v);
+        callStack.push_back(make_pair(v, static_cast<size_t>(graph.offsets[v])));
+    };
+
+    for (uint32_t root = 0; root < n; root++) {
+        if (index[root] != UNVISITED) {
+            continue;
+        }
+        open(root);
+        while (!callStack.empty()) {
+            uint32_t v = callStack.back().first;
+            size_t& e = callStack.back().second;
+            if (e < graph.offsets[v + 1]) {
+                uint32_t w = graph.targets[e++];
+                if (index[w] == UNVISITED) {
+                    open(w);
+                } else if (result.component[w] == NO_VERTEX) {
+                    low[v] = min(low[v], index[w]);  // w is still on Tarjan's stack.
+                }
+                continue;
+            }
+            callStack.pop_back();
+            if (low[v] == index[v]) {
+                uint32_t w;
+                do {
+                    w = stack.back();
+                    stack.pop_back();
+                    result.component[w] = result.count;
+                } while (w != v);
+                result.count++;
+            }
+            if (!callStack.empty()) {
+                uint32_t parent = callStack.back().first;
+                low[parent] = min(low[parent], low[v]);
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * Finds the connected components of an undirected graph, or the weakly connected components of a
+ * directed one, by uniting the endpoints of all edges in parallel through a ConcurrentUnionFind.
+ * Components are numbered in the order of their smallest vertex id.
+ *
+ * Args:
+ *     graph (const Csr&): The graph to analyze.
+ *     numThreads (unsigned): Number of threads, 0 for defaultThreadCount().
+ *
+ * Returns:
+ *     Components: The connected component of every vertex.
+ */
+template<typename Csr>
+Components connectedComponents(const Csr& graph, unsigned numThreads = 0) {
+    if (numThreads == 0) {
+        numThreads = defaultThreadCount();
+    }
+    size_t n = graph.numVertices();
+    ConcurrentUnionFind sets(n);
+    parallelFor(n, numThreads, [&](size_t begin, size_t end, unsigned) {
+        for (size_t v = begin; v < end; v++) {
+            for (size_t e = graph.offsets[v]; e < graph.offsets[v + 1]; e++) {
+                sets.unite(static_cast<uint32_t>(v), graph.targets[e]);
+            }
+        }
+    });
+
+    Components result;
+    result.component.resize(n);
+    result.count = 0;
+    vector<uint32_t> label(n, NO_VERTEX);
+    for (uint32_t v = 0; v < n; v++) {
+        uint32_t root = sets.find(v);
+        if (label[root] == NO_VERTEX) {
+            label[root] = result.count++;
+        }
+        result.component[v] = label[root];
+    }
+    return result;
+}
+
+/**
+ * Both the out- and in-neighbors of a CsrGraph, so the vertex orderings below treat a directed
+ * graph as undirected. The transpose is only built for a directed graph.
+ */
+class UndirectedView {
+public:
+    UndirectedView(const CsrGraph& graph) : graph(graph) {
+        if (graph.directional) {
+            incoming = graph.transpose();
+        }
+    }
+
+    size_t degree(uint32_t v) const {
+        return graph.degree(v) + (graph.directional ? incoming.degree(v) : 0);
+    }
+
+    template<typename Function>
+    void forEachNeighbor(uint32_t v, Function visit) const {
+        graph.forEachNeighbor(v, visit);
+        if (graph.directional) {
+            incoming.forEachNeighbor(v, visit);
+        }
+    }
+
+private:
+    const CsrGraph& graph;
+    CsrGraph incoming;
+};
+
+/**
+ * Orders the vertices by decreasing degree (in plus out), ties by id. Putting the high-degree
+ * vertices first packs the entries that traversals and PageRank touch most often into a few cache
+ * lines.
+ *
+ * Args:
+ *     graph (const CsrGraph&): The graph to order.
+ *
+ * Returns:
+ *     vector<uint32_t>: order[i] is the old id of the vertex placed at position i.
+ */
+vector<uint32_t> degreeOrder(const CsrGraph& graph) {
+    UndirectedView view(graph);
+    size_t n = graph.numVertices();
+    vector<size_t> degree(n);
+    size_t maxDegree = 0;
+    for (uint32_t v = 0; v < n; v++) {
+        degree[v] = view.degree(v);
+        maxDegree = max(maxDegree, degree[v]);
+    }
+    // Counting sort by decreasing degree; stable, so ties keep id order.
+    vector<size_t> start(maxDegree + 2, 0);
+    for (uint32_t v = 0; v < n; v++) {
+        start[maxDegree - degree[v] + 1]++;
+    }
+    for (size_t d = 1; d < start.size(); d++) {
+        start[d] += start[d - 1];
+    }
+    vector<uint32_t> order(n);
+    for (uint32_t v = 0; v < n; v++) {
+        order[start[maxDegree - degree[v]]++] = v;
+    }
+    return order;
+}
+
+/**
+ * Orders the vertices in breadth-first order, so each vertex lands near the vertex that discovered
+ * it. Every component is searched in turn, starting from its highest-degree vertex; edge direction
+ * is ignored.
+ *
+ * Args:
+ *     graph (const CsrGraph&): The graph to order.
+ *
+ * Returns:
+ *     vector<uint32_t>: order[i] is the old id of the vertex placed at position i.
+ */
+vector<uint32_t> bfsOrder(const CsrGraph& graph) {
+    UndirectedView view(graph);
+    size_t n = graph.numVertices();
+    vector<uint32_t> order;
+    order.reserve(n);
+    vector<bool> visited(n, false);
+    for (uint32_t root : degreeOrder(graph)) {
+        if (visited[root]) {
+            continue;
+        }
+        visited[root] = true;
+        size_t tail = order.size();
+        order.push_back(root);
+        for (; tail < order.size(); tail++) {
+            view.forEachNeighbor(order[tail], [&](uint32_t w) {
+                if (!visited[w]) {
+                    visited[w] = true;
+                    order.push_back(w);
+                }
+            });
+        }
+    }
+    return order;
+}
+
+/**
+ * Orders the vertices with the reverse Cuthill-McKee algorithm, which keeps the ids of adjacent
+ * vertices close together (a small bandwidth of the adjacency matrix). Each component is searched
+ * breadth-first from a pseudo-peripheral vertex, found by the George-Liu method of restarting from
+ * a minimum-degree vertex of the last BFS level while the eccentricity grows. The unvisited
+ * neighbors of each vertex are appended in increasing degree, and the whole order is reversed at
+ * the end. Edge direction is ignored.
+ *
+ * Args:
+ *     graph (const CsrGraph&): The graph to order.
+ *
+ * Returns:
+ *     vector<uint32_t>: order[i] is the old id of the vertex placed at position i.
+ */
+vector<uint32_t> reverseCuthillMcKeeOrder(const CsrGraph& graph) {
+    UndirectedView view(graph);
+    size_t n = graph.numVertices();
+    vector<size_t> degree(n);
+    for (uint32_t v = 0; v < n; v++) {
+        degree[v] = view.degree(v);
+    }
+    auto byDegree = [&](uint32_t a, uint32_t b) {
+        return degree[a] != degree[b] ? degree[a] < degree[b] : a < b;
+    };
+
+    vector<uint32_t> order;
+    order.reserve(n);
+    vector<bool> visited(n, false);
+    vector<uint32_t> stamp(n, NO_VERTEX);  // Last root search that reached each vertex.
+    uint32_t searches = 0;
+    vector<uint32_t> level;
+    vector<uint32_t> next;
+    vector<uint32_t> children;
+    vector<uint32_t> starts = degreeOrder(graph);
+    reverse(starts.begin(), starts.end());  // Increasing degree, ties by decreasing id.
+
+    for (uint32_t start : starts) {
+        if (visited[start]) {
+            continue;
+        }
+        // Pseudo-peripheral root: BFS level by level and move to the lowest-degree vertex of the
+        // last level while that makes the BFS deeper.
+        uint32_t root = start;
+        size_t eccentricity = 0;
+        for (uint32_t search = 0; ; search++) {
+            uint32_t mark = searches++;
+            level.assign(1, root);
+            stamp[root] = mark;
+            size_t depth = 0;
+            for (;;) {
+                next.clear();
+                for (uint32_t v : level) {
+                    view.forEachNeighbor(v, [&](uint32_t w) {
+                        if (stamp[w] != mark) {
+                            stamp[w] = mark;
+                            next.push_back(w);
+                        }
+                    });
+                }
+                if (next.empty()) {
+                    break;
+                }
+                level.swap(next);
+                depth++;
+            }
+            uint32_t candidate = *min_element(level.begin(), level.end(), byDegree);
+            if (search > 0 && depth <= eccentricity) {
+                break;
+            }
+            eccentricity = depth;
+            if (candidate == root) {
+                break;
+            }
+            root = candidate;
+        }
+
+        visited[root] = true;
+        size_t tail = order.size();
+        order.push_back(root);
+        for (; tail < order.size(); tail++) {
+            children.clear();
+            view.forEachNeighbor(order[tail], [&](uint32_t w) {
+                if (!visited[w]) {
+                    visited[w] = true;
+                    children.push_back(w);
+                }
+            });
+            sort(children.begin(), children.end(), byDegree);
+            order.insert(order.end(), children.begin(), children.end());
+        }
+    }
+    reverse(order.begin(), order.end());
+    return order;
+}
+
+/**
+ * A sparse matrix in compressed sparse row form, the layout used for SpMV-based graph analytics.
+ * Row i holds the columns columns[rowOffsets[i]..rowOffsets[i+1]) with the matching values. The
+ * same three arrays can be loaded into a SparseMatrix with SparseMatrix::fromCompressed.
+ *
+ * Attributes:
+ *     numRows (size_t): Number of rows.
+ *     numColumns (size_t): Number of columns.
+ *     rowOffsets (vector<size_t>): Start of every row in columns and values, plus the end of the last row.
+ *     columns (vector<uint32_t>): The column of every stored entry.
+ *     values (vector<double>): The value of every stored entry.
+ */
+struct CompressedSparseMatrix {
+    size_t numRows;
+    size_t numColumns;
+    vector<size_t> rowOffsets;
+    vector<uint32_t> columns;
+    vector<double> values;
+
+    CompressedSparseMatrix() : numRows(0), numColumns(0), rowOffsets(1, 0) {}
+
+    size_t numNonZeros() const {
+        return columns.size();
+    }
+
+    /**
+     * Computes y = A x on the threads of pool. Rows are split so that every thread gets about the
+     * same number of stored entries, which keeps the threads balanced on skewed degree distributions.
+     *
+     * Args:
+     *     x (vector<double>): The input vector, numColumns long.
+     *     y (vector<double>&): Receives the result, resized to numRows.
+     *     pool (ThreadPool&): The threads to use.
+     */
+    void multiply(const vector<double>& x, vector<double>& y, ThreadPool& pool) const {
+        y.resize(numRows);
+        unsigned parts = pool.size();
+        vector<size_t> split(parts + 1, numRows);
+        split[0] = 0;
+        for (unsigned p = 1; p < parts; p++) {
+            size_t goal = numNonZeros() / parts * p;
+            split[p] = upper_bound(rowOffsets.begin(), rowOffsets.end(), goal) - rowOffsets.begin() - 1;
+        }
+        pool.parallelFor(parts, [&](size_t begin, size_t end, unsigned) {
+            for (size_t p = begin; p < end; p++) {
+                for (size_t row = split[p]; row < split[p + 1]; row++) {
+                    double sum = 0;
+                    for (size_t e = rowOffsets[row]; e < rowOffsets[row + 1]; e++) {
+                        sum += values[e] * x[columns[e]];
+                    }
+                    y[row] = sum;
+                }
+            }
+        });
+    }
+
+    /**
+     * Computes A x with numThreads threads, 0 for defaultThreadCount().
+     */
+    vector<double> multiply(const vector<double>& x, unsigned numThreads = 0) const {
+        ThreadPool pool(numThreads);
+        vector<double> y;
+        multiply(x, y, pool);
+        return y;
+    }
+};
+
+/**
+ * Exports a graph as its adjacency matrix: entry (v, w) is the weight of the edge from v to w.
+ *
+ * Args:
+ *     graph (const CsrGraph&): The graph to export.
+ *
+ * Returns:
+ *     CompressedSparseMatrix: The numVertices x numVertices adjacency matrix.
+ */
+CompressedSparseMatrix adjacencyMatrix(const CsrGraph& graph) {
+    CompressedSparseMatrix matrix;
+    matrix.numRows = matrix.numColumns = graph.numVertices();
+    matrix.rowOffsets = graph.offsets;
+    matrix.columns = graph.targets;
+    matrix.values.assign(graph.weights.begin(), graph.weights.end());
+    return matrix;
+}
+
+/**
+ * Builds the transition matrix of the random walk on a graph, transposed for pull-style SpMV:
+ * entry (w, v) is the probability of stepping from v to w, 1/outdegree(v) or, when weighted, the
+ * edge weight over the total out-weight of v. Columns of vertices without out-edges (or without
+ * positive out-weight) are empty; PageRank hands their rank back through the teleport vector.
+ *
+ * Args:
+ *     graph (const CsrGraph&): The graph to walk.
+ *     weighted (bool): Whether the step probabilities follow the edge weights.
+ *
+ * Returns:
+ *     CompressedSparseMatrix: The transposed transition matrix.
+ *
+ * Throws:
+ *     invalid_argument: If weighted and an edge weight is negative.
+ */
+CompressedSparseMatrix transitionMatrix(const CsrGraph& graph, bool weighted = false) {
+    size_t n = graph.numVertices();
+    vector<double> outWeight(n, 0);
+    for (uint32_t v = 0; v < n; v++) {
+        for (size_t e = graph.offsets[v]; e < graph.offsets[v + 1]; e++) {
+            if (weighted && graph.weights[e] < 0) {
+                throw std::invalid_argument("Transition probabilities need non-negative weights");
+            }
+            outWeight[v] += weighted ? graph.weights[e] : 1.0;
+        }
+    }
+    CsrGraph incoming = graph.transpose();
+    CompressedSparseMatrix matrix;
+    matrix.numRows = matrix.numColumns = n;
+    matrix.rowOffsets = incoming.offsets;
+    matrix.columns = incoming.targets;
+    matrix.values.resize(incoming.numEdges());
+    for (size_t e = 0; e < incoming.numEdges(); e++) {
+        uint32_t from = incoming.targets[e];
+        matrix.values[e] = outWeight[from] > 0 ? (weighted ? incoming.weights[e] : 1.0) / outWeight[from] : 0;
+    }
+    return matrix;
+}
+
+/**
+ * Settings for pageRank and personalizedPageRank.
+ *
+ * Attributes:
+ *     damping (double): Probability of following an edge rather than teleporting, default 0.85.
+ *     tolerance (double): Pull: stop when the L1 change between iterations drops below it.
+ *                         Push: stop when every residual is below tolerance times the out-degree
+ *                         times the smallest teleport probability (1/n for pageRank).
+ *     maxIterations (unsigned): Pull: upper bound on the number of iterations.
+ *     weighted (bool): Whether the walk follows edges in proportion to their weight.
+ *     push (bool): Use local residual pushing instead of power iteration. Meant for personalized
+ *                  queries with few seeds; for global PageRank pull is much faster.
+ *     numThreads (unsigned): Pull: number of threads, 0 for defaultThreadCount().
+ */
+struct PageRankOptions {
+    double damping = 0.85;
+    double tolerance = 1e-6;
+    unsigned maxIterations = 100;
+    bool weighted = false;
+    bool push = false;
+    unsigned numThreads = 0;
+};
+
+/**
+ * Result of pageRank and personalizedPageRank.
+ *
+ * Attributes:
+ *     rank (vector<double>): The score of every vertex, indexed by dense id; the scores sum to about 1.
+ *     iterations (size_t): Pull: the number of iterations run. Push: the number of pushes.
+ *     residual (double): Pull: the last L1 change. Push: the rank mass left unassigned.
+ */
+struct PageRankResult {
+    vector<double> rank;
+    size_t iterations;
+    double residual;
+};
+
+/**
+ * Power iteration with the pull formulation: every iteration is one multithreaded SpMV with the
+ * transposed transition matrix, so each thread writes only its own rows and needs no atomics.
+ * Rank held by vertices without out-edges is spread like the teleport jumps.
+ */
+PageRankResult pullPageRank(const CsrGraph& graph, const vector<double>& teleport, const PageRankOptions& options) {
+    size_t n = graph.numVertices();
+    CompressedSparseMatrix transition = transitionMatrix(graph, options.weighted);
+    vector<uint32_t> dangling;
+    for (uint32_t v = 0; v < n; v++) {
+        bool leaves = false;
+        for (size_t e = graph.offsets[v]; e < graph.offsets[v + 1] && !leaves; e++) {
+            leaves = !options.weighted || graph.weights[e] > 0;
+        }
+        if (!leaves) {
+            dangling.push_back(v);
+        }
+    }
+
+    ThreadPool pool(options.numThreads);
+    PageRankResult result;
+    result.rank = teleport;
+    result.iterations = 0;
+    result.residual = numeric_limits<double>::infinity();
+    vector<double> walked;
+    vector<double> change(pool.size());
+    while (result.iterations < options.maxIterations && result.residual >= options.tolerance) {
+        double danglingRank = 0;
+        for (uint32_t v : dangling) {
+            danglingRank += result.rank[v];
+        }
+        transition.multiply(result.rank, walked, pool);
+        double jump = 1 - options.damping + options.damping * danglingRank;
+        fill(change.begin(), change.end(), 0);
+        pool.parallelFor(n, [&](size_t begin, size_t end, unsigned t) {
+            double sum = 0;
+            for (size_t v = begin; v < end; v++) {
+                double next = options.damping * walked[v] + jump * teleport[v];
+                sum += fabs(next - result.rank[v]);
+                result.rank[v] = next;
+            }
+            change[t] = sum;
+        });
+        result.residual = 0;
+        for (double c : change) {
+            result.residual += c;
+        }
+        result.iterations++;
+    }
+    return result;
+}
+
+/**
+ * Forward push (Andersen, Chung and Lang): every vertex holds a residual, initially the teleport
+ * vector. Pushing a vertex moves 1-damping of its residual into its rank and spreads the rest
+ * over its out-neighbors, or back over the teleport vector for a vertex without out-edges; that
+ * mass is collected and spread once the queue drains, so a dense teleport vector is not walked at
+ * every such push. Only vertices whose residual exceeds tolerance times their out-degree are
+ * pushed, so a personalized query with a few seeds touches just the neighborhood that matters.
+ * Runs on one thread.
+ *
+ * The threshold is scaled by the smallest teleport probability: with uniform teleport every initial
+ * residual is 1/n, and an unscaled threshold would leave large graphs with nothing to push. A
+ * tolerance so large that not even the teleport vertices are pushed would return all-zero ranks;
+ * that is reported as an error rather than returned. Otherwise the rank mass not yet assigned is
+ * returned as the residual.
+ */
+PageRankResult pushPageRank(const CsrGraph& graph, const vector<pair<uint32_t, double>>& teleport,
+                            const PageRankOptions& options) {
+    size_t n = graph.numVertices();
+    PageRankResult result;
+    result.rank.assign(n, 0);
+    result.iterations = 0;
+    vector<double> residual(n, 0);
+    vector<bool> queued(n, false);
+    deque<uint32_t> queue;
+    double scale = numeric_limits<double>::infinity();
+    for (auto& jump : teleport) {
+        if (jump.second > 0) {
+            scale = min(scale, jump.second);
+        }
+    }
+    auto threshold = [&](uint32_t v) {
+        return options.tolerance * scale * max<size_t>(graph.degree(v), 1);
+    };
+    auto add = [&](uint32_t v, double mass) {
+        residual[v] += mass;
+        if (!queued[v] && residual[v] > threshold(v)) {
+            queued[v] = true;
+            queue.push_back(v);
+        }
+    };
+    for (auto& jump : teleport) {
+        add(jump.first, jump.second);
+    }
+    double dangling = 0;
+    while (!queue.empty()) {
+        uint32_t v = queue.front();
+        queue.pop_front();
+        queued[v] = false;
+        double mass = residual[v];
+        residual[v] = 0;
+        result.rank[v] += (1 - options.damping) * mass;
+        result.iterations++;
+        double outWeight = 0;
+        for (size_t e = graph.offsets[v]; e < graph.offsets[v + 1]; e++) {
+            outWeight += options.weighted ? max(graph.weights[e], 0.0f) : 1.0;
+        }
+        double spread = options.damping * mass;
+        if (outWeight > 0) {
+            for (size_t e = graph.offsets[v]; e < graph.offsets[v + 1]; e++) {
+                double share = options.weighted ? max(graph.weights[e], 0.0f) : 1.0;
+                add(graph.targets[e], spread * share / outWeight);
+            }
+        } else {
+            dangling += spread;
+        }
+        if (queue.empty() && dangling > 0) {
+            for (auto& jump : teleport) {
+                add(jump.first, dangling * jump.second);
+            }
+            dangling = 0;
+        }
+    }
+    result.residual = 0;
+    for (double r : residual) {
+        result.residual += r;
+    }
+    if (result.iterations == 0 && result.residual > 0) {
+        throw std::runtime_error("Push tolerance too large: no vertex was pushed");
+    }
+    return result;
+}
+
+/**
+ * Shared driver of pageRank and personalizedPageRank, given a sparse teleport distribution.
+ */
+PageRankResult rankWithTeleport(const CsrGraph& graph, const vector<pair<uint32_t, double>>& teleport,
+                                const PageRankOptions& options) {
+    if (!(options.damping >= 0 && options.damping < 1)) {
+        throw std::invalid_argument("Damping must be in [0, 1)");
+    }
+    if (options.weighted) {
+        for (float w : graph.weights) {
+            if (w < 0) {
+                throw std::invalid_argument("Transition probabilities need non-negative weights");
+            }
+        }
+    }
+    if (options.push) {
+        return pushPageRank(graph, teleport, options);
+    }
+    vector<double> dense(graph.numVertices(), 0);
+    for (auto& jump : teleport) {
+        dense[jump.first] += jump.second;
+    }
+    return pullPageRank(graph, dense, options);
+}
+
+/**
+ * Computes PageRank: the stationary distribution of a walk that follows a random out-edge with
+ * probability damping and otherwise jumps to a uniformly random vertex.
+ *
+ * Args:
+ *     graph (const CsrGraph&): The graph to rank.
+ *     options (PageRankOptions): Damping, tolerance, variant and threads.
+ *
+ * Returns:
+ *     PageRankResult: The rank of every vertex and convergence information.
+ *
+ * Throws:
+ *     invalid_argument: If damping is outside [0, 1), or weighted is set and a weight is negative.
+ *     runtime_error: If push is set and the tolerance is so large that no vertex is pushed.
+ */
+PageRankResult pageRank(const CsrGraph& graph, const PageRankOptions& options = PageRankOptions()) {
+    size_t n = graph.numVertices();
+    vector<pair<uint32_t, double>> teleport;
+    teleport.reserve(n);
+    for (uint32_t v = 0; v < n; v++) {
+        teleport.push_back(make_pair(v, 1.0 / n));
+    }
+    return rankWithTeleport(graph, teleport, options);
+}
+
+/**
+ * Computes personalized PageRank: like pageRank, but every jump lands on one of the seed vertices,
+ * chosen uniformly. The push variant is the better fit when there are few seeds.
+ *
+ * Args:
+ *     graph (const CsrGraph&): The graph to rank.
+ *     seeds (vector<uint32_t>): Dense ids of the vertices to personalize for.
+ *     options (PageRankOptions): Damping, tolerance, variant and threads.
+ *
+ * Returns:
+ *     PageRankResult: The rank of every vertex relative to the seeds.
+ *
+ * Throws:
+ *     invalid_argument: If seeds is empty or has an unknown id, damping is outside [0, 1), or
+ *                       weighted is set and a weight is negative.
+ *     runtime_error: If push is set and the tolerance is so large that no vertex is pushed.
+ */
+PageRankResult personalizedPageRank(const CsrGraph& graph, const vector<uint32_t>& seeds,
+                                    const PageRankOptions& options = PageRankOptions()) {
+    if (seeds.empty()) {
+        throw std::invalid_argument("Personalized PageRank needs at least one seed");
+    }
+    vector<pair<uint32_t, double>> teleport;
+    for (uint32_t s : seeds) {
+        if (s >= graph.numVertices()) {
+            throw std::invalid_argument("Seed is not in the graph");
+        }
+        teleport.push_back(make_pair(s, 1.0 / seeds.size()));
+    }
+    return rankWithTeleport(graph, teleport, options);
+}
+
+/**
+ * Represents a graph structure with a list of vertices and methods to manipulate the graph,
+ * such as adding vertices and edges, and checking if a vertex exists.
+ *
+ * Every vertex identifier is interned once into a dense 32-bit index, and the vertices are stored
+ * in a flat vector at that index. The string-keyed methods translate the identifier with a single
+ * hash lookup; the index-based methods skip the translation entirely. Vertex pointers and
+ * references are invalidated when a new vertex is added.
+ * 
+ * Attributes:
+ *     keys (KeyInterner): Maps vertex identifiers to indices in vertList and back.
+ *     vertList (vector<Vertex>): The vertices, indexed by their interned index.
+ *     numVertices (int): Number of vertices in the graph.
+ *     directional (bool): Flag to check if the graph is directed.
+ */
+class Graph {
+public:
+    KeyInterner keys;
+    vector<Vertex> vertList;
+    int numVertices;
+    bool directional;
+
+    /**
+     * Constructor initializes an empty graph, optionally directed.
+     * 
+     * Args:
+     *     directed (bool): Specifies whether the graph is directed, default is true.
+     */
+    Graph(bool directed = true) : numVertices(0), directional(directed) {}
+
+    /**
+     * Returns the index of a vertex, adding the vertex if it doesn't exist.
+     *
+     * Args:
+     *     key (string_view): The unique identifier of the vertex.
+     *
+     * Returns:
+     *     uint32_t: The interned index of the vertex.
+     */
+    uint32_t intern(string_view key) {
+        uint32_t idx = keys.intern(key);
+        if (idx == vertList.size()) {
+            numVertices++;
+            vertList.push_back(Vertex(keys.name(idx), idx));
+        }
+        return idx;
+    }
+
+    /**
+     * Adds a vertex to the graph by key, initializing it if it doesn't exist.
+     * 
+     * Args:
+     *     key (string): The unique identifier for the new vertex.
+     * 
+     * Returns:
+     *     Vertex&: The vertex stored in the graph.
+     */
+    Vertex& addVertex(const string& key) {
+        return vertList[intern(key)];
+    }
+
+    /**
+     * Returns a pointer to the vertex if it exists, otherwise nullptr.
+     * 
+     * Args:
+     *     n (string): The identifier of the vertex to retrieve.
+     * 
+     * Returns:
+     *     Vertex*: A pointer to the vertex, or nullptr if it does not exist.
+     */
+    Vertex* getVertex(const string& n) {
+        uint32_t idx = keys.find(n);
+        if (idx != NO_VERTEX) {
+            return &vertList[idx];
+        }
+        return nullptr;
+    }
+
+    /**
+     * Returns the previous vertex of a vertex in the last traversal, resolved through this graph.
+     *
+     * Args:
+     *     vert (Vertex): A vertex of this graph.
+     *
+     * Returns:
+     *     Vertex*: A pointer to the previous vertex, or nullptr if it has none.
+     */
+    Vertex* getPrevious(const Vertex& vert) {
+        if (vert.previous != NO_VERTEX) {
+            return &vertList[vert.previous];
+        }
+        return nullptr;
+    }
+
+    /**
+     * Checks if a vertex with a specified identifier exists in the graph.
+     * 
+     * Args:
+     *     n (string): The identifier of the vertex to check.
+     * 
+     * Returns:
+     *     bool: True if the vertex exists, false otherwise.
+     */
+    bool contains(const string& n) const {
+        return keys.find(n) != NO_VERTEX;
+    }
+
+
+    /**
+     * Adds an edge between two vertices with an optional cost. If the vertices do not exist,
+     * they are added to the graph.
+     * 
+     * Args:
+     *     f (string): The identifier of the from vertex.
+     *     t (string): The identifier of the to vertex.
+     *     cost (float): The cost of the edge, defaulting to 1.0.
+     */
+    void addEdge(const string& f, const string& t, float cost = 1) {
+        uint32_t from = intern(f);
+        uint32_t to = intern(t);
+        addEdge(from, to, cost);
+    }
+
+    /**
+     * Adds an edge between two vertices that are already in the graph, by index.
+     *
+     * Args:
+     *     f (uint32_t): The index of the from vertex.
+     *     t (uint32_t): The index of the to vertex.
+     *     cost (float): The cost of the edge, defaulting to 1.0.
+     */
+    void addEdge(uint32_t f, uint32_t t, float cost = 1) {
+        vertList[f].addNeighbor(t, cost);
+        if (!directional) {
+            vertList[t].addNeighbor(f, cost); // Add the edge in the opposite direction for undirected graphs.
+        }
+    }
+
+    /**
+     * Adds a batch of edges between vertices that were already interned with intern().
+     *
+     * Args:
+     *     edges (vector<Edge>): The edges to add, given by vertex index.
+     *
+     * Throws:
+     *     out_of_range: If an edge refers to an index that is not in the graph. No edge is added in that case.
+     */
+    void addEdges(const vector<Edge>& edges) {
+        for (const Edge& edge : edges) {
+            if (edge.from >= vertList.size() || edge.to >= vertList.size()) {
+                throw std::out_of_range("Edge refers to an unknown vertex index");
+            }
+        }
+        for (const Edge& edge : edges) {
+            addEdge(edge.from, edge.to, edge.weight);
+        }
+    }
+
+    /**
+     * Applies a batch of edge insertions and deletions. The batch is sorted by (from, to) and each
+     * adjacency map is then visited once, with the updates for one edge applied in the order they
+     * were given, so the last update of an edge wins. In an undirected graph every update also
+     * applies to the reverse edge. Inserting an edge that exists only changes its weight.
+     *
+     * The returned net changes are what IncrementalBfs and IncrementalComponents consume: one entry
+     * per edge that was absent before the batch and present after it, or the reverse. In an
+     * undirected graph each such edge is reported once, with from <= to.
+     *
+     * Args:
+     *     updates (vector<EdgeUpdate>): The changes, given by vertex index.
+     *
+     * Returns:
+     *     vector<EdgeUpdate>: The edges that were actually inserted or deleted.
+     *
+     * Throws:
+     *     out_of_range: If an update refers to an index that is not in the graph. Nothing is changed in that case.
+     */
+    vector<EdgeUpdate> applyUpdates(const vector<EdgeUpdate>& updates) {
+        vector<EdgeUpdate> sorted;
+        sorted.reserve(directional ? updates.size() : 2 * updates.size());
+        for (const EdgeUpdate& update : updates) {
+            if (update.from >= vertList.size() || update.to >= vertList.size()) {
+                throw std::out_of_range("Edge refers to an unknown vertex index");
+            }
+            sorted.push_back(update);
+            if (!directional && update.from != update.to) {
+                sorted.push_back(EdgeUpdate{update.to, update.from, update.weight, update.remove});
+            }
+        }
+        stable_sort(sorted.begin(), sorted.end(), [](const EdgeUpdate& a, const EdgeUpdate& b) {
+            return a.from != b.from ? a.from < b.from : a.to < b.to;
+        });
+
+        vector<EdgeUpdate> changes;
+        size_t i = 0;
+        while (i < sorted.size()) {
+            uint32_t from = sorted[i].from;
+            uint32_t to = sorted[i].to;
+            map<uint32_t, float>& adjacent = vertList[from].connectedTo;
+            auto it = adjacent.lower_bound(to);
+            bool before = it != adjacent.end() && it->first == to;
+            bool present = before;
+            float weight = before ? it->second : 0;
+            for (; i < sorted.size() && sorted[i].from == from && sorted[i].to == to; i++) {
+                present = !sorted[i].remove;
+                if (present) {
+                    weight = sorted[i].weight;
+                }
+            }
+            if (present) {
+                if (before) {
+                    it->second = weight;
+                } else {
+                    adjacent.emplace_hint(it, to, weight);
+                }
+            } else if (before) {
+                adjacent.erase(it);
+            }
+            if (present != before && (directional || from <= to)) {
+                changes.push_back(EdgeUpdate{from, to, weight, !present});
+            }
+        }
+        return changes;
+    }
+
+    /**
+     * Retrieves a list of all vertex identifiers in the graph, in index order.
+     * 
+     * Returns:
+     *     vector<string>: A vector containing all vertex identifiers in the graph.
+     */
+    vector<string> getVertices() {
+        vector<string> verts;
+        for (auto& vert : vertList) {
+            verts.push_back(vert.id);
+        }
+        return verts;
+    }
+
+    /**
+     * Builds an immutable CSR snapshot of the graph. The snapshot uses the same vertex indices
+     * as the graph. Later changes to the graph are not reflected in the snapshot.
+     *
+     * This costs O(V + E), and the query helpers below (bfs, dijkstra, shortestPath and the rest)
+     * call it once per call; they are meant for one-shot queries. For many queries on an unchanged
+     * graph, freeze once and run the CsrGraph algorithms on the snapshot.
+     *
+     * Returns:
+     *     CsrGraph: The compressed snapshot of the current vertices and edges.
+     */
+    CsrGraph freeze() const {
+        CsrGraph csr(directional);
+        csr.keys = keys;
+        csr.offsets.reserve(vertList.size() + 1);
+        for (auto& vert : vertList) {
+            for (auto& edge : vert.connectedTo) {
+                csr.targets.push_back(edge.first);
+                csr.weights.push_back(edge.second);
+            }
+            csr.offsets.push_back(csr.targets.size());
+        }
+        return csr;
+    }
+
+    /**
+     * Renumbers the vertices and rebuilds the adjacency maps in the new order, e.g. with
+     * reverseCuthillMcKeeOrder(freeze()), so that later snapshots and traversals touch memory in a
+     * more local pattern. Vertex data and previous links are kept. Indices held by the caller are
+     * invalidated; inversePermutation(order) maps them to the new ones.
+     *
+     * Args:
+     *     order (vector<uint32_t>): order[i] is the current index of the vertex that gets index i.
+     *
+     * Throws:
+     *     invalid_argument: If order is not a permutation of the vertex indices.
+     */
+    void reorder(const vector<uint32_t>& order) {
+        if (order.size() != vertList.size()) {
+            throw std::invalid_argument("Vertex order is not a permutation");
+        }
+        vector<uint32_t> position = inversePermutation(order);
+        KeyInterner renamed;
+        renamed.reserve(order.size());
+        vector<Vertex> reordered;
+        reordered.reserve(order.size());
+        for (uint32_t old : order) {
+            Vertex vert = std::move(vertList[old]);
+            vert.index = renamed.intern(vert.id);
+            if (vert.previous != NO_VERTEX) {
+                vert.previous = position[vert.previous];
+            }
+            map<uint32_t, float> adjacent;
+            for (auto& edge : vert.connectedTo) {
+                adjacent.emplace(position[edge.first], edge.second);
+            }
+            vert.connectedTo.swap(adjacent);
+            reordered.push_back(std::move(vert));
+        }
+        keys = std::move(renamed);
+        vertList.swap(reordered);
+    }
+
+    /**
+     * Performs a breadth-first search from the start vertex with parallelBfs and stores the result
+     * in the vertices: distance is the hop count, previous the BFS tree parent, and every reached
+     * vertex is colored black. Unreached vertices are reset to white with infinite distance.
+     * Every call rebuilds the snapshot with freeze(); repeated searches should call parallelBfs
+     * on one snapshot.
+     *
+     * Args:
+     *     start (string): The identifier of the start vertex.
+     *     numThreads (unsigned): Number of threads, 0 for defaultThreadCount().
+     *
+     * Throws:
+     *     runtime_error: If the start vertex is not in the graph.
+     */
+    void bfs(const string& start, unsigned numThreads = 0) {
+        uint32_t source = keys.find(start);
+        if (source == NO_VERTEX) {
+            throw std::runtime_error("Vertex not found");
+        }
+        BfsResult result = parallelBfs(freeze(), source, numThreads);
+        for (size_t v = 0; v < vertList.size(); v++) {
+            Vertex& vert = vertList[v];
+            vert.distance = result.distance[v];
+            vert.previous = result.previous[v];
+            vert.color = result.distance[v] == numeric_limits<int>::max() ? "white" : "black";
+        }
+    }
+
+    /**
+     * Computes shortest paths from the start vertex with Dijkstra's algorithm and links every
+     * reached vertex to its predecessor through previous, so a path can be walked back from any
+     * vertex. Edge weights must be non-negative. The path costs are floats and are returned rather
+     * than stored in the integer distance field. Each call freezes the graph first; for several
+     * sources on an unchanged graph, reuse one snapshot and call CsrGraph::dijkstra on it.
+     *
+     * Args:
+     *     start (string): The identifier of the start vertex.
+     *
+     * Returns:
+     *     ShortestPaths: Path cost and previous vertex, indexed like vertList.
+     *
+     * Throws:
+     *     runtime_error: If the start vertex is not in the graph.
+     */
+    ShortestPaths dijkstra(const string& start) {
+        uint32_t source = keys.find(start);
+        if (source == NO_VERTEX) {
+            throw std::runtime_error("Vertex not found");
+        }
+        ShortestPaths result = freeze().dijkstra(source);
+        for (size_t v = 0; v < vertList.size(); v++) {
+            vertList[v].previous = result.previous[v];
+        }
+        return result;
+    }
+
+    /**
+     * Finds a cheapest path between two vertices, stopping as soon as the destination is settled.
+     * This is a one-shot helper: it builds a snapshot with freeze() and fresh search arrays on every
+     * call, both O(V + E), which outweighs the early stop. For repeated point-to-point queries, keep
+     * one CsrGraph and one DijkstraSearch over it and call run() per query; the search only resets
+     * the vertices the previous query touched.
+     *
+     * Args:
+     *     from (string): The identifier of the start vertex.
+     *     to (string): The identifier of the destination vertex.
+     *
+     * Returns:
+     *     vector<string>: The vertex identifiers along the path, empty if the destination is unreachable.
+     *
+     * Throws:
+     *     runtime_error: If either vertex is not in the graph.
+     */
+    vector<string> shortestPath(const string& from, const string& to) const {
+        uint32_t source = keys.find(from);
+        uint32_t target = keys.find(to);
+        if (source == NO_VERTEX || target == NO_VERTEX) {
+            throw std::runtime_error("Vertex not found");
+        }
+        CsrGraph csr = freeze();
+        DijkstraSearch search(csr);
+        search.run(vector<uint32_t>(1, source), target);
+        vector<string> path;
+        for (uint32_t v : search.pathTo(target)) {
+            path.push_back(keys.name(v));
+        }
+        return path;
+    }
+
+    /**
+     * Computes a minimum spanning forest of this undirected graph with minimumSpanningForest.
+     *
+     * Args:
+     *     numThreads (unsigned): Number of threads, 0 for defaultThreadCount().
+     *
+     * Returns:
+     *     vector<Edge>: The forest edges, by vertex index.
+     *
+     * Throws:
+     *     invalid_argument: If the graph is directed.
+     */
+    vector<Edge> minimumSpanningForest(unsigned numThreads = 0) const {
+        return ::minimumSpanningForest(freeze(), numThreads);
+    }
+
+    /**
+     * Exports the graph as a compressed sparse adjacency matrix, indexed like vertList.
+     *
+     * Returns:
+     *     CompressedSparseMatrix: Entry (v, w) is the weight of the edge from v to w.
+     */
+    CompressedSparseMatrix adjacencyMatrix() const {
+        return ::adjacencyMatrix(freeze());
+    }
+
+    /**
+     * Computes the PageRank of every vertex with pageRank.
+     *
+     * Args:
+     *     options (PageRankOptions): Damping, tolerance, variant and threads.
+     *
+     * Returns:
+     *     PageRankResult: The rank of every vertex, indexed like vertList.
+     */
+    PageRankResult pageRank(const PageRankOptions& options = PageRankOptions()) const {
+        return ::pageRank(freeze(), options);
+    }
+
+    /**
+     * Overloads the output stream operator to print all vertices and their connections in the graph.
+     * Each vertex is printed followed by its connections and weights.
+     * 
+     * Args:
+     *     stream (ostream&): The output stream.
+     *     grph (Graph&): The graph to be printed.
+     * 
+     * Returns:
+     *     ostream&: The output stream for chaining.
+     */
+    friend ostream &operator<<(ostream &stream, Graph &grph) {
+        for (auto& vert : grph.vertList) {
+            stream << vert.id << " -> ";
+            size_t i = 0;
+            for (auto& edge : vert.connectedTo) {
+                stream << grph.keys.name(edge.first) << " (Weight: " << edge.second << ")" << endl;
+                if (++i < vert.connectedTo.size()) stream << "\t";
+            }
+            cout << endl;
+        }
+        return stream;
+    }
+};
+
+/**
+ * Hop distances from a fixed source, kept current while the graph changes. After each
+ * Graph::applyUpdates, pass the returned changes to update(); only the region whose distance can
+ * change is visited, instead of running a new breadth-first search.
+ *
+ * Deletions are handled first. A vertex at distance d whose BFS parent edge was deleted looks for
+ * another in-neighbor at distance d-1. If there is none, it is marked as lost and its children are
+ * checked the same way, in increasing distance. Lost vertices then take their best distance
+ * through unaffected in-neighbors. Those vertices and the heads of inserted edges that got closer
+ * seed a Dijkstra pass with unit weights, which lowers distances until nothing improves.
+ *
+ * A directed graph needs in-neighbors, which Vertex does not store. The object keeps its own
+ * in-adjacency lists for that case and updates them from the changes. The graph must outlive the
+ * object.
+ *
+ * Attributes:
+ *     touched (size_t): Number of vertices examined by the last update, for measurement.
+ */
+class IncrementalBfs {
+public:
+    size_t touched;
+
+    /**
+     * Constructor runs the initial breadth-first search.
+     *
+     * Args:
+     *     graph (const Graph&): The graph to follow.
+     *     source (uint32_t): The index of the start vertex.
+     *
+     * Throws:
+     *     out_of_range: If the source is not in the graph.
+     */
+    IncrementalBfs(const Graph& graph, uint32_t source) : touched(0), graph(graph), source(source) {
+        if (source >= graph.vertList.size()) {
+            throw std::out_of_range("Source is not in the graph");
+        }
+        size_t n = graph.vertList.size();
+        grow();
+        if (graph.directional) {
+            for (uint32_t v = 0; v < n; v++) {
+                for (auto& edge : graph.vertList[v].connectedTo) {
+                    incoming[edge.first].push_back(v);
+                }
+            }
+        }
+        vector<uint32_t> frontier(1, source);
+        dist[source] = 0;
+        for (size_t head = 0; head < frontier.size(); head++) {
+            uint32_t v = frontier[head];
+            for (auto& edge : graph.vertList[v].connectedTo) {
+                if (dist[edge.first] == INF) {
+                    dist[edge.first] = dist[v] + 1;
+                    frontier.push_back(edge.first);
+                }
+            }
+        }
+        touched = frontier.size();
+    }
+
+    /**
+     * Returns the hop distance of a vertex, or the maximum int if it is unreachable.
+     */
+    int distance(uint32_t v) const {
+        return v < dist.size() ? dist[v] : INF;
+    }
+
+    /**
+     * Returns the hop distances of all vertices known at the last update, indexed like vertList.
+     */
+    const vector<int>& distances() const {
+        return dist;
+    }
+
+    /**
+     * Repairs the distances after a batch of changes. Vertices added to the graph since the last
+     * update start out unreachable.
+     *
+     * Args:
+     *     changes (vector<EdgeUpdate>): The net changes returned by Graph::applyUpdates.
+     */
+    void update(const vector<EdgeUpdate>& changes) {
+        grow();
+        touched = 0;
+        vector<pair<uint32_t, uint32_t>> inserted;
+        vector<pair<uint32_t, uint32_t>> deleted;
+        for (const EdgeUpdate& change : changes) {
+            vector<pair<uint32_t, uint32_t>>& arcs = change.remove ? deleted : inserted;
+            arcs.push_back(make_pair(change.from, change.to));
+            if (!graph.directional && change.from != change.to) {
+                arcs.push_back(make_pair(change.to, change.from));
+            }
+        }
+        if (graph.directional) {
+            for (auto& arc : inserted) {
+                incoming[arc.second].push_back(arc.first);
+            }
+            for (auto& arc : deleted) {
+                vector<uint32_t>& in = incoming[arc.second];
+                auto it = std::find(in.begin(), in.end(), arc.first);
+                if (it != in.end()) {
+                    *it = in.back();
+                    in.pop_back();
+                }
+            }
+        }
+
+        // Find the vertices that lost every shortest path, in increasing distance, so the parents
+        // of a vertex are classified before the vertex itself.
+        for (auto& arc : deleted) {
+            uint32_t v = arc.second;
+            if (v != source && dist[arc.first] != INF && dist[v] == dist[arc.first] + 1 && !queue.contains(v)) {
+                queue.insert(v, static_cast<float>(dist[v]));
+            }
+        }
+        vector<uint32_t> lost;
+        while (!queue.isEmpty()) {
+            uint32_t v = queue.delMin().second;
+            touched++;
+            if (hasParent(v)) {
+                continue;
+            }
+            lost.push_back(v);
+            affected[v] = 1;
+            for (auto& edge : graph.vertList[v].connectedTo) {
+                uint32_t w = edge.first;
+                if (w != source && dist[w] == dist[v] + 1 && !affected[w] && !queue.contains(w)) {
+                    queue.insert(w, static_cast<float>(dist[w]));
+                }
+            }
+        }
+
+        // Give lost vertices their best distance through the vertices that kept theirs.
+        for (uint32_t v : lost) {
+            dist[v] = INF;
+        }
+        for (uint32_t v : lost) {
+            forEachIncoming(v, [&](uint32_t w) {
+                if (!affected[w] && dist[w] != INF && dist[w] + 1 < dist[v]) {
+                    dist[v] = dist[w] + 1;
+                }
+            });
+            if (dist[v] != INF) {
+                queue.insert(v, static_cast<float>(dist[v]));
+            }
+        }
+        for (uint32_t v : lost) {
+            affected[v] = 0;
+        }
+        for (auto& arc : inserted) {
+            relax(arc.first, arc.second);
+        }
+
+        while (!queue.isEmpty()) {
+            uint32_t v = queue.delMin().second;
+            touched++;
+            for (auto& edge : graph.vertList[v].connectedTo) {
+                relax(v, edge.first);
+            }
+        }
+    }
+
+private:
+    static constexpr int INF = numeric_limits<int>::max();
+
+    const Graph& graph;
+    uint32_t source;
+    vector<int> dist;
+    vector<char> affected;
+    vector<vector<uint32_t>> incoming;  // Only filled for directed graphs.
+    IndexedMinHeap queue;
+
+    void grow() {
+        size_t n = graph.vertList.size();
+        dist.resize(n, INF);
+        affected.resize(n, 0);
+        if (graph.directional) {
+            incoming.resize(n);
+        }
+        queue.grow(n);
+    }
+
+    template<typename Function>
+    void forEachIncoming(uint32_t v, Function f) const {
+        if (graph.directional) {
+            for (uint32_t w : incoming[v]) {
+                f(w);
+            }
+        } else {
+            for (auto& edge : graph.vertList[v].connectedTo) {
+                f(edge.first);
+            }
+        }
+    }
+
+    bool hasParent(uint32_t v) const {
+        bool found = false;
+        forEachIncoming(v, [&](uint32_t w) {
+            found = found || (!affected[w] && dist[w] != INF && dist[w] + 1 == dist[v]);
+        });
+        return found;
+    }
+
+    void relax(uint32_t from, uint32_t to) {
+        if (dist[from] != INF && dist[from] + 1 < dist[to]) {
+            dist[to] = dist[from] + 1;
+            queue.insertOrDecrease(to, static_cast<float>(dist[to]));
+        }
+    }
+};
+
+/**
+ * Connected-component labels of an undirected graph, kept current while the graph changes. After
+ * each Graph::applyUpdates, pass the returned changes to update().
+ *
+ * Labels are stable ids that are reused after a component disappears, so they are not contiguous;
+ * components() returns a compact numbering. Deletions are handled first, on the graph without the
+ * edges the batch inserted. For the endpoints of deleted edges, two breadth-first searches run in
+ * lockstep, one from each endpoint. If they meet, the component is still connected. If one side
+ * runs out first, it is a new component and only that side is relabeled, so the cost follows the
+ * smaller side. Each inserted edge that joins two components then relabels the smaller one.
+ * The graph must outlive the object.
+ *
+ * Attributes:
+ *     touched (size_t): Number of vertices visited by the last update, for measurement.
+ */
+class IncrementalComponents {
+public:
+    size_t touched;
+
+    /**
+     * Constructor labels the current components with connectedComponents.
+     *
+     * Args:
+     *     graph (const Graph&): The undirected graph to follow.
+     *
+     * Throws:
+     *     invalid_argument: If the graph is directed.
+     */
+    IncrementalComponents(const Graph& graph) : touched(0), graph(graph), live(0), epoch(0) {
+        if (graph.directional) {
+            throw std::invalid_argument("Incremental components require an undirected graph");
+        }
+        Components initial = connectedComponents(graph.freeze());
+        label = initial.component;
+        sizes.assign(initial.count, 0);
+        for (uint32_t l : label) {
+            sizes[l]++;
+        }
+        live = initial.count;
+        touched = label.size();
+    }
+
+    /**
+     * Returns the label of the component that contains a vertex.
+     */
+    uint32_t componentOf(uint32_t v) const {
+        return label[v];
+    }
+
+    /**
+     * Returns the number of components.
+     */
+    uint32_t count() const {
+        return live;
+    }
+
+    /**
+     * Returns the components numbered 0..count-1 in the order of their smallest vertex id, the
+     * numbering connectedComponents uses.
+     */
+    Components components() const {
+        Components result;
+        result.component.resize(label.size());
+        result.count = 0;
+        vector<uint32_t> compact(sizes.size(), NO_VERTEX);
+        for (size_t v = 0; v < label.size(); v++) {
+            if (compact[label[v]] == NO_VERTEX) {
+                compact[label[v]] = result.count++;
+            }
+            result.component[v] = compact[label[v]];
+        }
+        return result;
+    }
+
+    /**
+     * Repairs the labels after a batch of changes. Vertices added to the graph since the last
+     * update start out as components of their own.
+     *
+     * Args:
+     *     changes (vector<EdgeUpdate>): The net changes returned by Graph::applyUpdates.
+     */
+    void update(const vector<EdgeUpdate>& changes) {
+        touched = 0;
+        while (label.size() < graph.vertList.size()) {
+            uint32_t l = newLabel();
+            sizes[l] = 1;
+            label.push_back(l);
+        }
+        stamp.resize(label.size(), 0);
+
+        skipped.clear();
+        unordered_map<uint32_t, vector<uint32_t>> endpoints;
+        for (const EdgeUpdate& change : changes) {
+            if (!change.remove) {
+                skipped.insert(edgeKey(change.from, change.to));
+            } else if (change.from != change.to) {
+                vector<uint32_t>& ends = endpoints[label[change.from]];
+                ends.push_back(change.from);
+                ends.push_back(change.to);
+            }
+        }
+
+        // Every piece a component splits into contains an endpoint of a deleted edge. Compare each
+        // endpoint that still has the old label with one representative of the old label.
+        for (auto& group : endpoints) {
+            uint32_t old = group.first;
+            uint32_t rep = NO_VERTEX;
+            for (uint32_t v : group.second) {
+                if (label[v] != old || v == rep) {
+                    continue;
+                }
+                if (rep == NO_VERTEX || label[rep] != old) {
+                    rep = v;
+                    continue;
+                }
+                int side = separate(rep, v);
+                if (side < 0) {
+                    continue;
+                }
+                uint32_t fresh = newLabel();
+                for (uint32_t w : frontier[side]) {
+                    label[w] = fresh;
+                }
+                sizes[fresh] = frontier[side].size();
+                sizes[old] -= frontier[side].size();
+                if (side == 0) {
+                    rep = v;
+                }
+            }
+        }
+        skipped.clear();
+
+        for (const EdgeUpdate& change : changes) {
+            uint32_t a = label[change.from];
+            uint32_t b = label[change.to];
+            if (change.remove || a == b) {
+                continue;
+            }
+            uint32_t start = sizes[a] < sizes[b] ? change.from : change.to;
+            merge(start, sizes[a] < sizes[b] ? b : a);
+        }
+    }
+
+private:
+    const Graph& graph;
+    vector<uint32_t> label;
+    vector<size_t> sizes;            // Vertices per label, 0 for free labels.
+    vector<uint32_t> freeLabels;
+    uint32_t live;
+    vector<uint32_t> stamp;          // Search side marks, valid when equal to epoch or epoch + 1.
+    uint32_t epoch;
+    vector<uint32_t> frontier[2];
+    unordered_set<uint64_t> skipped; // Edges the batch inserted, ignored while checking deletions.
+
+    static uint64_t edgeKey(uint32_t a, uint32_t b) {
+        return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+    }
+
+    uint32_t newLabel() {
+        live++;
+        if (!freeLabels.empty()) {
+            uint32_t l = freeLabels.back();
+            freeLabels.pop_back();
+            return l;
+        }
+        sizes.push_back(0);
+        return static_cast<uint32_t>(sizes.size() - 1);
+    }
+
+    /**
+     * Searches from a and b in lockstep, one vertex at a time. Returns -1 if the searches meet,
+     * otherwise the side (0 for a, 1 for b) that ran out first, with its component in frontier[side].
+     */
+    int separate(uint32_t a, uint32_t b) {
+        if (epoch >= numeric_limits<uint32_t>::max() - 2) {
+            fill(stamp.begin(), stamp.end(), 0);
+            epoch = 0;
+        }
+        epoch += 2;
+        uint32_t start[2] = {a, b};
+        size_t head[2] = {0, 0};
+        for (int side = 0; side < 2; side++) {
+            frontier[side].assign(1, start[side]);
+            stamp[start[side]] = epoch + side;
+        }
+        for (int side = 0; ; side ^= 1) {
+            if (head[side] == frontier[side].size()) {
+                return side;
+            }
+            uint32_t v = frontier[side][head[side]++];
+            touched++;
+            for (auto& edge : graph.vertList[v].connectedTo) {
+                uint32_t w = edge.first;
+                if (!skipped.empty() && skipped.count(edgeKey(v, w))) {
+                    continue;
+                }
+                if (stamp[w] == epoch + (side ^ 1)) {
+                    return -1;
+                }
+                if (stamp[w] != epoch + side) {
+                    stamp[w] = epoch + side;
+                    frontier[side].push_back(w);
+                }
+            }
+        }
+    }
+
+    /**
+     * Moves the component containing start to the label target and frees its old label.
+     */
+    void merge(uint32_t start, uint32_t target) {
+        uint32_t old = label[start];
+        vector<uint32_t> stack(1, start);
+        label[start] = target;
+        while (!stack.empty()) {
+            uint32_t v = stack.back();
+            stack.pop_back();
+            touched++;
+            for (auto& edge : graph.vertList[v].connectedTo) {
+                if (label[edge.first] == old) {
+                    label[edge.first] = target;
+                    stack.push_back(edge.first);
+                }
+            }
+        }
+        sizes[target] += sizes[old];
+        sizes[old] = 0;
+        freeLabels.push_back(old);
+        live--;
+    }
+};
+
+/**
+ * Helper function to replace a specific character in a string with an underscore,
+ * used to generate blanked forms of words.
+ * 
+ * Args:
+ *     str (string): The original string.
+ *     index (int): The position of the character to be replaced.
+ * 
+ * Returns:
+ *     string: The modified string with the specified character replaced by an underscore.
+ */
+string getBlank(string str, int index) {
+    string blank = str;
+    blank[index] = '_';
+    return blank;
+}
+
+/**
+ * Index of the blanked forms ("buckets") of a word list, the structure behind the word-ladder graph.
+ * Two distinct words are neighbors exactly when they share a bucket.
+ *
+ * The blanked forms are never materialized as strings. Every (word, position) pair gets a 64-bit
+ * polynomial hash of the word with that position treated as '_', derived from the hash of the whole
+ * word in O(1), and pairs are grouped by hash with an exact character comparison to separate
+ * collisions. Hashing runs in parallel over shards of the word list, and grouping runs in parallel
+ * over partitions of the hash space. Only buckets with at least two words are kept.
+ *
+ * The index can expand neighbors implicitly with forEachNeighbor, or materialize a Graph either with
+ * a clique per bucket (toGraph, the textbook construction) or with one hub vertex per bucket
+ * (toHubGraph), which needs k edges instead of k(k-1)/2 for a bucket of k words.
+ *
+ * Attributes:
+ *     words (KeyInterner): The distinct words; duplicates in the input share one id.
+ *     wordOffsets (vector<size_t>): The buckets of word w are wordBuckets[wordOffsets[w] .. wordOffsets[w + 1]).
+ *     wordBuckets (vector<uint32_t>): Bucket of every (word, position), NO_VERTEX if no other word shares it.
+ *     bucketOffsets (vector<size_t>): The words of bucket b are bucketWords[bucketOffsets[b] .. bucketOffsets[b + 1]).
+ *     bucketWords (vector<uint32_t>): Word ids grouped by bucket.
+ *     bucketBlanks (vector<uint32_t>): The blanked position of every bucket.
+ */
+class WordLadderIndex {
+public:
+    KeyInterner words;
+    vector<size_t> wordOffsets;
+    vector<uint32_t> wordBuckets;
+    vector<size_t> bucketOffsets;
+    vector<uint32_t> bucketWords;
+    vector<uint32_t> bucketBlanks;
+
+    /**
+     * Constructor builds the index.
+     *
+     * Args:
+     *     wordList (vector<string>): The words to index.
+     *     numThreads (unsigned): Number of threads, 0 for defaultThreadCount().
+     */
+    WordLadderIndex(const vector<string>& wordList, unsigned numThreads = 0) {
+        if (numThreads == 0) {
+            numThreads = defaultThreadCount();
+        }
+        words.reserve(wordList.size());
+        for (const string& word : wordList) {
+            words.intern(word);
+        }
+        size_t n = words.size();
+        wordOffsets.assign(n + 1, 0);
+        for (size_t w = 0; w < n; w++) {
+            wordOffsets[w + 1] = wordOffsets[w] + words.name(w).size();
+        }
+
+        // Hash every blanked form, one shard of words per thread.
+        vector<Pattern> patterns(wordOffsets[n]);
+        parallelFor(n, numThreads, [&](size_t begin, size_t end, unsigned) {
+            for (size_t w = begin; w < end; w++) {
+                const string& word = words.name(w);
+                uint64_t full = 0;
+                for (unsigned char c : word) {
+                    full = full * HASH_BASE + c;
+                }
+                uint64_t power = 1;
+                for (size_t i = word.size(); i-- > 0;) {
+                    uint64_t blanked = full + (uint64_t('_') - static_cast<unsigned char>(word[i])) * power;
+                    patterns[wordOffsets[w] + i] = {mix(blanked ^ word.size()), static_cast<uint32_t>(w), static_cast<uint32_t>(i)};
+                    power *= HASH_BASE;
+                }
+            }
+        });
+
+        // Partition by the top hash bits so that equal blanked forms always land in the same partition.
+        unsigned partitions = numThreads;
+        vector<size_t> partitionOffsets(partitions + 1, 0);
+        for (const Pattern& pattern : patterns) {
+            partitionOffsets[partitionOf(pattern.hash, partitions) + 1]++;
+        }
+        for (unsigned p = 0; p < partitions; p++) {
+            partitionOffsets[p + 1] += partitionOffsets[p];
+        }
+        vector<Pattern> sorted(patterns.size());
+        vector<size_t> next(partitionOffsets.begin(), partitionOffsets.end() - 1);
+        for (const Pattern& pattern : patterns) {
+            sorted[next[partitionOf(pattern.hash, partitions)]++] = pattern;
+        }
+        patterns.clear();
+        patterns.shrink_to_fit();
+
+        // Sort and group every partition in parallel, keeping the groups with two or more words.
+        vector<vector<pair<size_t, size_t>>> groups(partitions);
+        parallelFor(partitions, numThreads, [&](size_t begin, size_t end, unsigned) {
+            for (size_t p = begin; p < end; p++) {
+                auto first = sorted.begin() + partitionOffsets[p];
+                auto last = sorted.begin() + partitionOffsets[p + 1];
+                sort(first, last, [this](const Pattern& a, const Pattern& b) { return patternLess(a, b); });
+                for (size_t i = partitionOffsets[p]; i < partitionOffsets[p + 1];) {
+                    size_t j = i + 1;
+                    while (j < partitionOffsets[p + 1] && !patternLess(sorted[i], sorted[j])) {
+                        j++;
+                    }
+                    if (j - i > 1) {
+                        groups[p].push_back(make_pair(i, j));
+                    }
+                    i = j;
+                }
+            }
+        });
+
+        wordBuckets.assign(wordOffsets[n], NO_VERTEX);
+        bucketOffsets.assign(1, 0);
+        for (auto& partition : groups) {
+            for (auto& group : partition) {
+                uint32_t bucket = static_cast<uint32_t>(bucketOffsets.size() - 1);
+                bucketBlanks.push_back(sorted[group.first].blank);
+                for (size_t i = group.first; i < group.second; i++) {
+                    bucketWords.push_back(sorted[i].word);
+                    wordBuckets[wordOffsets[sorted[i].word] + sorted[i].blank] = bucket;
+                }
+                bucketOffsets.push_back(bucketWords.size());
+            }
+        }
+    }
+
+    /**
+     * Returns the number of distinct words, i.e. the vertices of the implicit word-ladder graph.
+     */
+    size_t numVertices() const {
+        return words.size();
+    }
+
+    /**
+     * Returns the number of buckets with two or more words.
+     */
+    size_t numBuckets() const {
+        return bucketOffsets.size() - 1;
+    }
+
+    /**
+     * Returns the blanked form of a bucket, e.g. "f_ol".
+     */
+    string pattern(uint32_t bucket) const {
+        return getBlank(words.name(bucketWords[bucketOffsets[bucket]]), bucketBlanks[bucket]);
+    }
+
+    /**
+     * Calls visit(neighbor) for every word that differs from the given word in exactly one letter,
+     * reading the buckets directly instead of a materialized edge list. Every neighbor is visited once.
+     *
+     * Args:
+     *     word (uint32_t): The id of the word.
+     *     visit (Function): Called with the id of each neighbor.
+     */
+    template<typename Function>
+    void forEachNeighbor(uint32_t word, Function visit) const {
+        for (size_t i = wordOffsets[word]; i < wordOffsets[word + 1]; i++) {
+            uint32_t bucket = wordBuckets[i];
+            if (bucket == NO_VERTEX) {
+                continue;
+            }
+            for (size_t j = bucketOffsets[bucket]; j < bucketOffsets[bucket + 1]; j++) {
+                if (bucketWords[j] != word) {
+                    visit(bucketWords[j]);
+                }
+            }
+        }
+    }
+
+    /**
+     * Builds the undirected word-ladder graph with an edge between every pair of words in a bucket.
+     * Vertex indices equal word ids, and words without neighbors are included as isolated vertices.
+     */
+    Graph toGraph() const {
+        Graph g(false);
+        internWords(g);
+        vector<Edge> edges;
+        for (uint32_t b = 0; b < numBuckets(); b++) {
+            edges.clear();
+            for (size_t i = bucketOffsets[b]; i < bucketOffsets[b + 1]; i++) {
+                for (size_t j = i + 1; j < bucketOffsets[b + 1]; j++) {
+                    edges.push_back({bucketWords[i], bucketWords[j], 1});
+                }
+            }
+            g.addEdges(edges);
+        }
+        return g;
+    }
+
+    /**
+     * Builds an undirected graph with one hub vertex per bucket and an edge of weight 0.5 between
+     * the hub and every word of the bucket. Word vertex indices equal word ids, and hubs follow them.
+     * A hub is keyed by its blanked form prefixed with '*', e.g. "*f_ol", with more '*' added if a
+     * word already has that key, so a word containing '_' never merges with a hub. A ladder of k
+     * steps is a path of 2k edges and cost k, so Dijkstra costs match the clique graph while BFS hop
+     * counts are doubled.
+     */
+    Graph toHubGraph() const {
+        Graph g(false);
+        internWords(g);
+        vector<Edge> edges;
+        for (uint32_t b = 0; b < numBuckets(); b++) {
+            string key = "*" + pattern(b);
+            while (g.contains(key)) {
+                key.insert(0, 1, '*');
+            }
+            uint32_t hub = g.intern(key);
+            edges.clear();
+            for (size_t i = bucketOffsets[b]; i < bucketOffsets[b + 1]; i++) {
+                edges.push_back({hub, bucketWords[i], 0.5f});
+            }
+            g.addEdges(edges);
+        }
+        return g;
+    }
+
+private:
+    static const uint64_t HASH_BASE = 1099511628211ULL;
+
+    // One blanked form: the hash, and the word and position it was derived from.
+    struct Pattern {
+        uint64_t hash;
+        uint32_t word;
+        uint32_t blank;
+    };
+
+    // Finalizer of splitmix64; spreads the polynomial hash over all bits for partitioning.
+    static uint64_t mix(uint64_t x) {
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    static unsigned partitionOf(uint64_t hash, unsigned partitions) {
+        return static_cast<unsigned>((hash >> 32) * partitions >> 32);
+    }
+
+    // Orders blanked forms by hash, then by their characters, without building the strings.
+    bool patternLess(const Pattern& a, const Pattern& b) const {
+        if (a.hash != b.hash) {
+            return a.hash < b.hash;
+        }
+        const string& x = words.name(a.word);
+        const string& y = words.name(b.word);
+        if (x.size() != y.size()) {
+            return x.size() < y.size();
+        }
+        for (size_t i = 0; i < x.size(); i++) {
+            char cx = i == a.blank ? '_' : x[i];
+            char cy = i == b.blank ? '_' : y[i];
+            if (cx != cy) {
+                return cx < cy;
+            }
+        }
+        return false;
+    }
+
+    void internWords(Graph& g) const {
+        g.keys.reserve(words.size());
+        g.vertList.reserve(words.size());
+        for (uint32_t w = 0; w < words.size(); w++) {
+            g.intern(words.name(w));
+        }
+    }
+};
+
+/**
+ * Constructs a graph from a list of words by connecting words that differ by one letter.
+ * Words are grouped by their blanked forms with a WordLadderIndex, and words in the same
+ * group are connected with an edge. Lists shorter than PARALLEL_THRESHOLD words are indexed on
+ * one thread, since starting threads would cost more than the work.
+ * 
+ * Args:
+ *     words (vector<string>): The list of words to be processed.
+ * 
+ * Returns:
+ *     Graph: A graph where each word is a vertex and edges connect words differing by one letter.
+ */
+Graph buildGraph(vector<string> words) {
+    const size_t PARALLEL_THRESHOLD = 1 << 14;
+    return WordLadderIndex(words, words.size() < PARALLEL_THRESHOLD ? 1 : 0).toGraph();
+}
+
+
+/**
+ * Point-to-point shortest-path engine for unweighted graphs that runs a breadth-first search from
+ * both endpoints and stops where the two searches meet. Each step expands a full level of the side
+ * with the smaller frontier, which explores roughly the square root of what a one-sided BFS visits.
+ *
+ * The per-vertex scratch arrays are allocated once and invalidated between queries by bumping a
+ * query stamp, so a query only costs what it explores. The graph type only needs numVertices() and
+ * forEachNeighbor(v, visit): a CsrGraph works, and so does a WordLadderIndex, which expands ladder
+ * neighbors straight from its buckets without a materialized edge list.
+ *
+ * Attributes:
+ *     expanded (size_t): Number of vertices whose neighbors were expanded by the last query.
+ */
+template<typename Neighbors>
+class BidirectionalBfs {
+public:
+    size_t expanded;
+
+    /**
+     * Constructor for undirected graphs, where both searches follow the same edges.
+     *
+     * Args:
+     *     graph (const Neighbors&): The graph to search. It must outlive the engine.
+     */
+    BidirectionalBfs(const Neighbors& graph) : BidirectionalBfs(graph, graph) {}
+
+    /**
+     * Constructor for directed graphs: the backward search follows the edges of the transposed graph.
+     *
+     * Args:
+     *     forward (const Neighbors&): The graph to search.
+     *     backward (const Neighbors&): The same graph with every edge reversed.
+     */
+    BidirectionalBfs(const Neighbors& forward, const Neighbors& backward)
+        : expanded(0), forward(forward), backward(backward), epoch(0), meet(NO_VERTEX) {
+        for (int side = 0; side < 2; side++) {
+            stamp[side].assign(forward.numVertices(), 0);
+            dist[side].resize(forward.numVertices());
+            parent[side].resize(forward.numVertices());
+        }
+    }
+
+    /**
+     * Finds the length of a shortest path between two vertices.
+     *
+     * Args:
+     *     source (uint32_t): The dense id of the start vertex.
+     *     target (uint32_t): The dense id of the destination vertex.
+     *
+     * Returns:
+     *     int: The number of edges on a shortest path, numeric_limits<int>::max() if there is none.
+     */
+    int query(uint32_t source, uint32_t target) {
+        nextEpoch();
+        expanded = 0;
+        meet = NO_VERTEX;
+        best = numeric_limits<int>::max();
+        for (int side = 0; side < 2; side++) {
+            frontier[side].clear();
+        }
+        mark(0, source, NO_VERTEX, 0);
+        mark(1, target, NO_VERTEX, 0);
+        frontier[0].push_back(source);
+        frontier[1].push_back(target);
+        if (source == target) {
+            meet = source;
+            best = 0;
+            return best;
+        }
+        while (!frontier[0].empty() && !frontier[1].empty()) {
+            expandLevel(frontier[0].size() <= frontier[1].size() ? 0 : 1);
+            // Finishing the whole level before stopping guarantees the best meeting point was seen.
+            if (best != numeric_limits<int>::max()) {
+                break;
+            }
+        }
+        return best;
+    }
+
+    /**
+     * Returns the vertices of the shortest path found by the last query, both endpoints included,
+     * or an empty vector if the endpoints are not connected.
+     */
+    vector<uint32_t> path() const {
+        vector<uint32_t> result;
+        if (meet == NO_VERTEX) {
+            return result;
+        }
+        for (uint32_t v = meet; v != NO_VERTEX; v = parent[0][v]) {
+            result.push_back(v);
+        }
+        reverse(result.begin(), result.end());
+        for (uint32_t v = parent[1][meet]; v != NO_VERTEX; v = parent[1][v]) {
+            result.push_back(v);
+        }
+        return result;
+    }
+
+private:
+    const Neighbors& forward;
+    const Neighbors& backward;
+    vector<uint32_t> stamp[2];     // stamp[side][v] == epoch if the side has reached v in this query.
+    vector<int> dist[2];
+    vector<uint32_t> parent[2];
+    vector<uint32_t> frontier[2];
+    vector<uint32_t> next;
+    uint32_t epoch;
+    uint32_t meet;
+    int best;
+
+    void nextEpoch() {
+        if (++epoch == 0) {
+            for (int side = 0; side < 2; side++) {
+                fill(stamp[side].begin(), stamp[side].end(), 0);
+            }
+            epoch = 1;
+        }
+    }
+
+    bool reached(int side, uint32_t v) const {
+        return stamp[side][v] == epoch;
+    }
+
+    void mark(int side, uint32_t v, uint32_t from, int distance) {
+        stamp[side][v] = epoch;
+        dist[side][v] = distance;
+        parent[side][v] = from;
+    }
+
+    void expandLevel(int side) {
+        const Neighbors& graph = side == 0 ? forward : backward;
+        next.clear();
+        for (uint32_t v : frontier[side]) {
+            expanded++;
+            graph.forEachNeighbor(v, [&](uint32_t w) {
+                if (reached(side, w)) {
+                    return;
+                }
+                mark(side, w, v, dist[side][v] + 1);
+                next.push_back(w);
+                if (reached(1 - side, w) && dist[0][w] + dist[1][w] < best) {
+                    best = dist[0][w] + dist[1][w];
+                    meet = w;
+                }
+            });
+        }
+        frontier[side].swap(next);
+    }
+};
+
+/**
+ * Callbacks invoked by a depth-first search. Every method has an empty default, so a visitor only
+ * overrides the events it needs. Vertex ids are of type Id: dense uint32_t ids for
+ * DepthFirstSearch over a CsrGraph, and the original int ids for DFSGraph::dfs.
+ */
+template<typename Id>
+struct DfsVisitor {
+    virtual ~DfsVisitor() {}
+
+    // Called when a vertex is first reached, with its discovery time.
+    virtual void discover(Id, int) {}
+
+    // Called when all descendants of a vertex are done, with its closing time.
+    virtual void finish(Id, int) {}
+
+    // Called for an edge that leads to an undiscovered vertex.
+    virtual void treeEdge(Id, Id) {}
+
+    // Called for an edge that leads to a vertex that is still open, i.e. an edge that closes a cycle.
+    virtual void backEdge(Id, Id) {}
+};
+
+/**
+ * Depth-first search engine over a CsrGraph, or any graph with the same CSR layout such as
+ * MappedGraph. It keeps an explicit stack instead of recursing, so
+ * arbitrarily long paths cannot overflow the call stack, and tracks visited vertices in a dense
+ * bitmap. Discovery and closing times follow the textbook convention: a single clock starting at 1
+ * that ticks on every discovery and every finish.
+ *
+ * Attributes:
+ *     discovery_time (vector<int>): Discovery time of every vertex, 0 if not reached.
+ *     closing_time (vector<int>): Closing time of every vertex, 0 if not finished.
+ *     previous (vector<uint32_t>): Parent in the DFS forest, NO_VERTEX for roots and unreached vertices.
+ */
+template<typename Csr = CsrGraph>
+class DepthFirstSearch {
+public:
+    vector<int> discovery_time;
+    vector<int> closing_time;
+    vector<uint32_t> previous;
+
+    /**
+     * Constructor prepares an engine for the given graph. The graph must outlive the engine.
+     *
+     * Args:
+     *     graph (const Csr&): The graph to search.
+     */
+    DepthFirstSearch(const Csr& graph)
+        : discovery_time(graph.numVertices(), 0), closing_time(graph.numVertices(), 0),
+          previous(graph.numVertices(), NO_VERTEX), graph(graph),
+          visited((graph.numVertices() + 63) / 64, 0), time(0) {}
+
+    /**
+     * Searches the whole graph, starting a new tree from every vertex that is still unvisited,
+     * in id order.
+     *
+     * Args:
+     *     visitor (DfsVisitor<uint32_t>&): Receives the search events.
+     */
+    void run(DfsVisitor<uint32_t>& visitor) {
+        for (uint32_t v = 0; v < graph.numVertices(); v++) {
+            if (!isVisited(v)) {
+                visit(v, visitor);
+            }
+        }
+    }
+
+    /**
+     * Searches the vertices reachable from source that have not been visited yet.
+     *
+     * Args:
+     *     source (uint32_t): The dense id of the root vertex.
+     *     visitor (DfsVisitor<uint32_t>&): Receives the search events.
+     */
+    void visit(uint32_t source, DfsVisitor<uint32_t>& visitor) {
+        if (isVisited(source)) {
+            return;
+        }
+        open(source, visitor);
+        while (!stack.empty()) {
+            uint32_t v = stack.back().first;
+            size_t& e = stack.back().second;
+            if (e == graph.offsets[v + 1]) {
+                stack.pop_back();
+                closing_time[v] = ++time;
+                visitor.finish(v, time);
+                continue;
+            }
+            uint32_t w = graph.targets[e++];
+            if (!isVisited(w)) {
+                previous[w] = v;
+                visitor.treeEdge(v, w);
+                open(w, visitor);
+            } else if (closing_time[w] == 0) {
+                visitor.backEdge(v, w);
+            }
+        }
+    }
+
+    /**
+     * Checks whether a vertex has been reached by the search.
+     *
+     * Args:
+     *     v (uint32_t): The dense id of the vertex.
+     */
+    bool isVisited(uint32_t v) const {
+        return (visited[v >> 6] >> (v & 63)) & 1;
+    }
+
+private:
+    const Csr& graph;
+    vector<uint64_t> visited;                 // One bit per vertex.
+    vector<pair<uint32_t, size_t>> stack;     // (vertex, next edge to examine)
+    int time;
+
+    void open(uint32_t v, DfsVisitor<uint32_t>& visitor) {
+        visited[v >> 6] |= uint64_t(1) << (v & 63);
+        discovery_time[v] = ++time;
+        visitor.discover(v, time);
+        stack.push_back(make_pair(v, graph.offsets[v]));
+    }
+};
+
+/**
+ * Orders the vertices of a directed acyclic graph so that every edge points forward, using the
+ * reverse of the DFS finishing order.
+ *
+ * Args:
+ *     graph (const CsrGraph&): The directed graph to sort.
+ *
+ * Returns:
+ *     vector<uint32_t>: Dense vertex ids in topological order.
+ *
+ * Throws:
+ *     runtime_error: If the graph contains a cycle.
+ */
+vector<uint32_t> topologicalSort(const CsrGraph& graph) {
+    struct FinishOrder : DfsVisitor<uint32_t> {
+        vector<uint32_t> order;
+        void finish(uint32_t v, int) override {
+            order.push_back(v);
+        }
+        void backEdge(uint32_t, uint32_t) override {
+            throw std::runtime_error("Graph contains a cycle");
+        }
+    } visitor;
+    visitor.order.reserve(graph.numVertices());
+    DepthFirstSearch(graph).run(visitor);
+    reverse(visitor.order.begin(), visitor.order.end());
+    return visitor.order;
+}
+
+/**
+ * Class representing a depth-first search (DFS) specific graph structure. It maintains a map
+ * of vertex identifiers to vertices, where each vertex has a list of connected vertices.
+ * This class is tailored for performing depth-first searches, especially in directed or
+ * undirected graphs.
+ * 
+ * Attributes:
+ *     vertices (graph_t): A map from vertex identifiers to vertex structures containing
+ *                          vertex data and adjacency lists.
+ *     directional (bool): Indicates whether the graph is directed or not.
+ */
+class DFSGraph{
+    typedef std::pair<int, std::list<int>> vertex_t;  // Pair containing vertex identifier and list of neighbors.
+    typedef std::map<int, vertex_t> graph_t;  // Type alias for the graph data structure.
+
+public:
+    const bool directional;  // Flag to indicate if the graph is directed.
+
+    /**
+     * Constructor for DFSGraph that initializes it as either directed or undirected.
+     * 
+     * Args:
+     *     directional (bool): Specifies whether the graph is directed.
+     */
+    DFSGraph(bool directional) : directional(directional) {}
+
+    /**
+     * Checks if a vertex with the given identifier exists in the graph.
+     * 
+     * Args:
+     *     id (int): The identifier of the vertex to check.
+     * 
+     * Returns:
+     *     bool: True if the vertex exists, false otherwise.
+     */
+    bool containsVertex(int id) {
+        return vertices.count(id) > 0;
     }
 
     /**
@@ -387,6 +4128,31 @@ public:
         return vertices[id];
     }
 
+    /**
+     * Builds an immutable CSR snapshot of the graph. Vertices receive dense ids in ascending
+     * id order, the CSR keys are the decimal vertex ids, and every edge has weight 1.
+     *
+     * Returns:
+     *     CsrGraph: The compressed snapshot of the current vertices and edges.
+     */
+    CsrGraph freeze() const {
+        CsrGraph csr(directional);
+        csr.keys.reserve(vertices.size());
+        csr.offsets.reserve(vertices.size() + 1);
+        unordered_map<int, uint32_t> dense;
+        for (auto& cur : vertices) {
+            dense[cur.first] = csr.keys.intern(std::to_string(cur.first));
+        }
+        for (auto& cur : vertices) {
+            for (int neighborID : cur.second.second) {
+                csr.targets.push_back(dense[neighborID]);
+                csr.weights.push_back(1);
+            }
+            csr.offsets.push_back(csr.targets.size());
+        }
+        return csr;
+    }
+
     /**
      * Adds an edge between two vertices. If the vertices do not exist, they are created.
      * 
@@ -407,36 +4173,667 @@ public:
     }
 
     /**
-     * Performs a depth-first search across the graph, starting from any unvisited vertices.
+     * Performs a depth-first search across the graph, starting a new tree from every unvisited
+     * vertex in ascending id order. The search runs on a CSR snapshot without recursion.
+     * 
+     * Args:
+     *     visitor (DfsVisitor<int>&): Receives discovery, finish and edge events by vertex id.
+     */
+    void dfs(DfsVisitor<int>& visitor) const {
+        CsrGraph csr = freeze();
+        IdMappingVisitor mapped(vertexIds(), visitor);
+        DepthFirstSearch(csr).run(mapped);
+    }
+
+    /**
+     * Orders the vertices so that every edge points forward. The graph must be directed and acyclic.
+     *
+     * Returns:
+     *     vector<int>: Vertex ids in topological order.
+     *
+     * Throws:
+     *     runtime_error: If the graph contains a cycle.
+     */
+    vector<int> topologicalSort() const {
+        vector<int> ids = vertexIds();
+        vector<int> order;
+        order.reserve(ids.size());
+        for (uint32_t v : ::topologicalSort(freeze())) {
+            order.push_back(ids[v]);
+        }
+        return order;
+    }
+
+    /**
+     * Finds the strongly connected components of the graph with the iterative Tarjan algorithm.
+     *
+     * Returns:
+     *     Components: The component of every vertex, indexed like vertexIds().
+     */
+    Components stronglyConnectedComponents() const {
+        return ::stronglyConnectedComponents(freeze());
+    }
+
+    /**
+     * Finds the connected components of the graph with a parallel union-find. For a directed
+     * graph these are the weakly connected components.
+     *
+     * Args:
+     *     numThreads (unsigned): Number of threads, 0 for defaultThreadCount().
+     *
+     * Returns:
+     *     Components: The component of every vertex, indexed like vertexIds().
      */
-    void dfs() {
-        std::list<int> visitedList;
+    Components connectedComponents(unsigned numThreads = 0) const {
+        return ::connectedComponents(freeze(), numThreads);
+    }
 
+    /**
+     * Returns the vertex ids in ascending order. Position i holds the vertex with dense id i in
+     * freeze() and in the component arrays.
+     */
+    vector<int> vertexIds() const {
+        vector<int> ids;
+        ids.reserve(vertices.size());
         for (auto& cur : vertices) {
-            if (std::find(visitedList.begin(), visitedList.end(), cur.first) == visitedList.end()) {
-                dfsvisit(visitedList, cur.second);
+            ids.push_back(cur.first);
+        }
+        return ids;
+    }
+
+private:
+    graph_t vertices;  // Map of vertices where key is the vertex ID and value is a pair of ID and list of connected vertices.
+
+    // Translates the dense ids of a CSR snapshot back to vertex ids before forwarding each event.
+    struct IdMappingVisitor : DfsVisitor<uint32_t> {
+        vector<int> ids;
+        DfsVisitor<int>& inner;
+
+        IdMappingVisitor(vector<int> ids, DfsVisitor<int>& inner) : ids(std::move(ids)), inner(inner) {}
+
+        void discover(uint32_t v, int time) override { inner.discover(ids[v], time); }
+        void finish(uint32_t v, int time) override { inner.finish(ids[v], time); }
+        void treeEdge(uint32_t from, uint32_t to) override { inner.treeEdge(ids[from], ids[to]); }
+        void backEdge(uint32_t from, uint32_t to) override { inner.backEdge(ids[from], ids[to]); }
+    };
+
+};
+
+/**
+ * Header of the binary graph file written by writeGraphFile and opened by MappedGraph. All numbers
+ * are stored in the byte order of the machine that wrote the file, and every section starts at an
+ * 8-byte aligned position recorded in the header:
+ *
+ *     keyOffsets  uint64_t[numVertices + 1]  start of each vertex key in the key blob
+ *     keyBlob     char[]                     the vertex keys, back to back, without terminators
+ *     sortedKeys  uint32_t[numVertices]      vertex ids ordered by key, for lookup by binary search
+ *     offsets     uint64_t[numVertices + 1]  CSR edge range of each vertex
+ *     targets     uint32_t[numEdges]         head of every edge
+ *     weights     float[numEdges]            weight of every edge
+ *
+ * Attributes:
+ *     magic (char[8]): Always "CPDSGRPH".
+ *     version (uint32_t): Format version, GRAPH_FILE_VERSION for files written by this code.
+ *     byteOrder (uint32_t): 0x01020304 as written; any other value means a foreign byte order.
+ *     directional (uint32_t): 1 for a directed graph, 0 for an undirected one.
+ */
+struct GraphFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t directional;
+    uint32_t reserved;
+    uint64_t numVertices;
+    uint64_t numEdges;
+    uint64_t keyOffsetsPos;
+    uint64_t keyBlobPos;
+    uint64_t sortedKeysPos;
+    uint64_t offsetsPos;
+    uint64_t targetsPos;
+    uint64_t weightsPos;
+    uint64_t fileSize;
+};
+
+const uint32_t GRAPH_FILE_VERSION = 1;
+
+/**
+ * Writes a CSR snapshot in the binary graph format described at GraphFileHeader. The file is
+ * written under a unique temporary name next to its destination, flushed to disk and renamed into
+ * place, so a reader never sees a partial file and a crash leaves either the old or the new file.
+ *
+ * Args:
+ *     graph (const CsrGraph&): The graph to write, e.g. from Graph::freeze().
+ *     path (string): The destination file.
+ *
+ * Throws:
+ *     runtime_error: If the file cannot be written.
+ */
+void writeGraphFile(const CsrGraph& graph, const string& path) {
+    size_t n = graph.numVertices();
+    size_t m = graph.numEdges();
+    auto align = [](uint64_t pos) { return (pos + 7) & ~uint64_t(7); };
+
+    vector<uint64_t> keyOffsets(n + 1, 0);
+    for (uint32_t v = 0; v < n; v++) {
+        keyOffsets[v + 1] = keyOffsets[v] + graph.keys.name(v).size();
+    }
+    vector<uint32_t> sortedKeys(n);
+    for (uint32_t v = 0; v < n; v++) {
+        sortedKeys[v] = v;
+    }
+    sort(sortedKeys.begin(), sortedKeys.end(), [&graph](uint32_t a, uint32_t b) {
+        return graph.keys.name(a) < graph.keys.name(b);
+    });
+
+    GraphFileHeader header = {};
+    memcpy(header.magic, "CPDSGRPH", 8);
+    header.version = GRAPH_FILE_VERSION;
+    header.byteOrder = 0x01020304;
+    header.directional = graph.directional ? 1 : 0;
+    header.numVertices = n;
+    header.numEdges = m;
+    header.keyOffsetsPos = align(sizeof(GraphFileHeader));
+    header.keyBlobPos = align(header.keyOffsetsPos + (n + 1) * sizeof(uint64_t));
+    header.sortedKeysPos = align(header.keyBlobPos + keyOffsets[n]);
+    header.offsetsPos = align(header.sortedKeysPos + n * sizeof(uint32_t));
+    header.targetsPos = align(header.offsetsPos + (n + 1) * sizeof(uint64_t));
+    header.weightsPos = align(header.targetsPos + m * sizeof(uint32_t));
+    header.fileSize = header.weightsPos + m * sizeof(float);
+
+    string tmpPath = path + ".XXXXXX";
+    int fd = mkstemp(&tmpPath[0]);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot write graph file " + path);
+    }
+    uint64_t written = 0;
+    bool ok = true;
+    auto put = [&](const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        while (ok && size > 0) {
+            ssize_t done = ::write(fd, bytes, size);
+            ok = done > 0;
+            if (ok) {
+                bytes += done;
+                size -= done;
+                written += done;
             }
         }
+    };
+    auto writeAt = [&](uint64_t pos, const void* data, size_t size) {
+        static const char zeros[8] = {};
+        put(zeros, pos - written);
+        put(data, size);
+    };
+    put(&header, sizeof(header));
+    writeAt(header.keyOffsetsPos, keyOffsets.data(), keyOffsets.size() * sizeof(uint64_t));
+    writeAt(header.keyBlobPos, nullptr, 0);
+    for (uint32_t v = 0; v < n; v++) {
+        put(graph.keys.name(v).data(), graph.keys.name(v).size());
     }
+    writeAt(header.sortedKeysPos, sortedKeys.data(), n * sizeof(uint32_t));
+    vector<uint64_t> offsets(graph.offsets.begin(), graph.offsets.end());
+    writeAt(header.offsetsPos, offsets.data(), offsets.size() * sizeof(uint64_t));
+    writeAt(header.targetsPos, graph.targets.data(), m * sizeof(uint32_t));
+    writeAt(header.weightsPos, graph.weights.data(), m * sizeof(float));
+    ok = ok && ::fchmod(fd, 0644) == 0 && ::fsync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    if (!ok || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        throw std::runtime_error("Cannot write graph file " + path);
+    }
+    // Make the rename itself durable.
+    size_t slash = path.find_last_of('/');
+    string dir = slash == string::npos ? "." : path.substr(0, slash + 1);
+    int dirFd = ::open(dir.c_str(), O_RDONLY);
+    if (dirFd >= 0) {
+        ::fsync(dirFd);
+        ::close(dirFd);
+    }
+}
 
+/**
+ * Read-only memory mapping of a whole file, unmapped when the object is destroyed.
+ */
+class MappedFile {
+public:
     /**
-     * A helper function for the DFS that visits vertices recursively.
-     * 
+     * Constructor maps the file.
+     *
      * Args:
-     *     visitedList (std::list<int>&): A list tracking visited vertex identifiers.
-     *     vertex (vertex_t&): The current vertex structure to visit.
+     *     path (string): The file to map.
+     *
+     * Throws:
+     *     runtime_error: If the file cannot be opened or mapped.
      */
-    void dfsvisit(std::list<int>& visitedList, vertex_t& vertex) {
-        visitedList.push_back(vertex.first);
-        std::cout << "Visited Vertex With ID#: " << vertex.first << std::endl;
-
-        for (int neighborID : vertex.second.second) {
-            if (std::find(visitedList.begin(), visitedList.end(), neighborID) == visitedList.end()) {
-                dfsvisit(visitedList, vertices[neighborID]);
+    MappedFile(const string& path) : bytes(nullptr), length(0) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot open " + path);
+        }
+        length = info.st_size;
+        if (length > 0) {
+            void* mapped = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Cannot map " + path);
             }
+            bytes = static_cast<const char*>(mapped);
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile() {
+        if (bytes != nullptr) {
+            munmap(const_cast<char*>(bytes), length);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const {
+        return bytes;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+    /**
+     * Tells the kernel the mapping will be read front to back, so it reads ahead aggressively.
+     */
+    void adviseSequential() const {
+        if (bytes != nullptr) {
+            madvise(const_cast<char*>(bytes), length, MADV_SEQUENTIAL);
         }
     }
 
 private:
-    graph_t vertices;  // Map of vertices where key is the vertex ID and value is a pair of ID and list of connected vertices.
+    const char* bytes;
+    size_t length;
+};
+
+/**
+ * Read-only graph backed by a memory-mapped file in the format written by writeGraphFile. Opening
+ * maps and validates the file; the arrays are used in place, and with checkArrays off startup does
+ * not depend on the graph size and pages are loaded on first touch. The class exposes the same CSR layout as CsrGraph,
+ * so breadthFirstSearch, DijkstraSearch, DepthFirstSearch and BidirectionalBfs work on it directly.
+ *
+ * Attributes:
+ *     offsets (const uint64_t*): Start of each vertex's edge range, with one extra entry at the end.
+ *     targets (const uint32_t*): Dense id of the head of every edge.
+ *     weights (const float*): Weight of every edge, parallel to targets.
+ *     directional (bool): Whether the graph is directed.
+ */
+class MappedGraph {
+public:
+    const uint64_t* offsets;
+    const uint32_t* targets;
+    const float* weights;
+    bool directional;
+
+    /**
+     * Constructor maps and validates a graph file. By default every offset, key offset and edge
+     * target is checked, which reads the arrays once; a corrupt file is rejected instead of causing
+     * out-of-bounds reads later. A service that reopens files it wrote itself can skip that pass.
+     *
+     * Args:
+     *     path (string): The file to open.
+     *     checkArrays (bool): Whether to check the arrays; false checks only the header and section bounds.
+     *
+     * Throws:
+     *     runtime_error: If the file cannot be mapped or is not a valid graph file of this version.
+     */
+    MappedGraph(const string& path, bool checkArrays = true) : file(path), data(file.data()), size(file.size()) {
+        if (size < sizeof(GraphFileHeader)) {
+            throw std::runtime_error("Not a graph file: " + path);
+        }
+        validate();
+        if (checkArrays) {
+            validateArrays();
+        }
+    }
+
+    MappedGraph(const MappedGraph&) = delete;
+    MappedGraph& operator=(const MappedGraph&) = delete;
+
+    size_t numVertices() const {
+        return header().numVertices;
+    }
+
+    size_t numEdges() const {
+        return header().numEdges;
+    }
+
+    size_t degree(uint32_t v) const {
+        return offsets[v + 1] - offsets[v];
+    }
+
+    /**
+     * Returns the original identifier of a vertex, pointing into the mapped file.
+     */
+    string_view key(uint32_t v) const {
+        return string_view(keyBlob + keyOffsets[v], keyOffsets[v + 1] - keyOffsets[v]);
+    }
+
+    /**
+     * Returns the dense id of a vertex by binary search over the sorted key table.
+     *
+     * Args:
+     *     name (string_view): The original identifier of the vertex.
+     *
+     * Returns:
+     *     uint32_t: The dense id, or NO_VERTEX if the vertex does not exist.
+     */
+    uint32_t indexOf(string_view name) const {
+        const uint32_t* first = sortedKeys;
+        const uint32_t* last = sortedKeys + numVertices();
+        const uint32_t* it = lower_bound(first, last, name, [this](uint32_t v, string_view k) {
+            return key(v) < k;
+        });
+        return (it != last && key(*it) == name) ? *it : NO_VERTEX;
+    }
+
+    template<typename Function>
+    void forEachNeighbor(uint32_t v, Function visit) const {
+        for (size_t e = offsets[v]; e < offsets[v + 1]; e++) {
+            visit(targets[e]);
+        }
+    }
+
+    BfsResult bfs(uint32_t source) const {
+        return breadthFirstSearch(*this, source);
+    }
+
+    ShortestPaths dijkstra(uint32_t source) const {
+        DijkstraSearch<MappedGraph> search(*this);
+        search.run(vector<uint32_t>(1, source));
+        return search.result();
+    }
+
+private:
+    MappedFile file;
+    const char* data;
+    size_t size;
+    const uint64_t* keyOffsets;
+    const char* keyBlob;
+    const uint32_t* sortedKeys;
+
+    const GraphFileHeader& header() const {
+        return *reinterpret_cast<const GraphFileHeader*>(data);
+    }
+
+    // Checks the header and that every section lies inside the file, then sets the section pointers.
+    // Only the first and last entries of the offset arrays are read.
+    void validate() {
+        const GraphFileHeader& h = header();
+        if (memcmp(h.magic, "CPDSGRPH", 8) != 0) {
+            throw std::runtime_error("Not a graph file");
+        }
+        if (h.version != GRAPH_FILE_VERSION) {
+            throw std::runtime_error("Unsupported graph file version " + std::to_string(h.version));
+        }
+        if (h.byteOrder != 0x01020304) {
+            throw std::runtime_error("Graph file has a different byte order");
+        }
+        uint64_t n = h.numVertices;
+        uint64_t m = h.numEdges;
+        auto inside = [this](uint64_t pos, uint64_t bytes) {
+            return pos % 8 == 0 && pos <= size && bytes <= size - pos;
+        };
+        if (h.fileSize != size || n >= NO_VERTEX || m > size ||
+            !inside(h.keyOffsetsPos, (n + 1) * sizeof(uint64_t)) ||
+            !inside(h.sortedKeysPos, n * sizeof(uint32_t)) ||
+            !inside(h.offsetsPos, (n + 1) * sizeof(uint64_t)) ||
+            !inside(h.targetsPos, m * sizeof(uint32_t)) ||
+            !inside(h.weightsPos, m * sizeof(float))) {
+            throw std::runtime_error("Truncated or corrupt graph file");
+        }
+        keyOffsets = reinterpret_cast<const uint64_t*>(data + h.keyOffsetsPos);
+        keyBlob = data + h.keyBlobPos;
+        sortedKeys = reinterpret_cast<const uint32_t*>(data + h.sortedKeysPos);
+        offsets = reinterpret_cast<const uint64_t*>(data + h.offsetsPos);
+        targets = reinterpret_cast<const uint32_t*>(data + h.targetsPos);
+        weights = reinterpret_cast<const float*>(data + h.weightsPos);
+        directional = h.directional != 0;
+        if (h.keyBlobPos > size || keyOffsets[n] > size - h.keyBlobPos || offsets[0] != 0 || offsets[n] != m) {
+            throw std::runtime_error("Truncated or corrupt graph file");
+        }
+    }
+
+    // Checks that every offset, key offset and id in the arrays stays in bounds, so that lookups and
+    // traversals cannot read outside the mapping.
+    void validateArrays() const {
+        uint64_t n = numVertices();
+        uint64_t m = numEdges();
+        bool valid = keyOffsets[0] == 0;
+        for (uint64_t v = 0; v < n && valid; v++) {
+            valid = keyOffsets[v] <= keyOffsets[v + 1] && offsets[v] <= offsets[v + 1] && sortedKeys[v] < n;
+        }
+        for (uint64_t e = 0; e < m && valid; e++) {
+            valid = targets[e] < n;
+        }
+        if (!valid) {
+            throw std::runtime_error("Corrupt graph file");
+        }
+    }
 };
+
+// One edge as parsed from a text buffer; the keys point into the buffer.
+struct ParsedEdge {
+    string_view from;
+    string_view to;
+    float weight;
+};
+
+// Splits the next token off the front of line. Tokens are separated by blanks, tabs or commas.
+string_view nextToken(string_view& line) {
+    size_t start = line.find_first_not_of(" \t,\r");
+    if (start == string_view::npos) {
+        line = string_view();
+        return line;
+    }
+    size_t end = line.find_first_of(" \t,\r", start);
+    if (end == string_view::npos) {
+        end = line.size();
+    }
+    string_view token = line.substr(start, end - start);
+    line.remove_prefix(end);
+    return token;
+}
+
+// Parses a whole token as a number. Returns false if the token is not exactly one number.
+template<typename Number>
+bool parseNumber(string_view token, Number& value) {
+    auto result = from_chars(token.data(), token.data() + token.size(), value);
+    return result.ec == errc() && result.ptr == token.data() + token.size();
+}
+
+/**
+ * Parses the edges of one chunk of an edge list or of the arc section of a DIMACS file.
+ *
+ * Edge lists have one "from to [weight]" edge per line, separated by blanks, tabs or commas; the
+ * weight defaults to 1, extra columns are ignored, and lines starting with '#' or '%' are comments.
+ * DIMACS lines are "a from to weight" arcs with positive integer ids, or "c" comments.
+ *
+ * Args:
+ *     text (string_view): The chunk, starting at the beginning of a line.
+ *     dimacs (bool): Whether the chunk is in DIMACS format.
+ *     edges (vector<ParsedEdge>&): Receives the parsed edges.
+ *
+ * Returns:
+ *     size_t: Offset of the first malformed line within text, or string_view::npos if there is none.
+ */
+size_t parseEdgeChunk(string_view text, bool dimacs, vector<ParsedEdge>& edges) {
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == string_view::npos) {
+            eol = text.size();
+        }
+        string_view line = text.substr(pos, eol - pos);
+        string_view first = nextToken(line);
+        if (!first.empty() && first[0] != '#' && first[0] != '%' && !(dimacs && first == "c")) {
+            ParsedEdge edge;
+            edge.weight = 1;
+            if (dimacs) {
+                long id;
+                edge.from = nextToken(line);
+                edge.to = nextToken(line);
+                if (first != "a" || !parseNumber(edge.from, id) || id <= 0 || !parseNumber(edge.to, id) || id <= 0 ||
+                    !parseNumber(nextToken(line), edge.weight)) {
+                    return pos;
+                }
+            } else {
+                edge.from = first;
+                edge.to = nextToken(line);
+                string_view weight = nextToken(line);
+                if (edge.to.empty() || (!weight.empty() && !parseNumber(weight, edge.weight))) {
+                    return pos;
+                }
+            }
+            edges.push_back(edge);
+        }
+        pos = eol + 1;
+    }
+    return string_view::npos;
+}
+
+/**
+ * Parses edges from a text buffer and adds them to a graph in batches through addEdges. Vertex keys
+ * are tokens of the buffer, interned without building intermediate strings. The buffer is split
+ * into chunks of about 4 MiB at line boundaries and processed in rounds of one chunk per thread: the
+ * chunks of a round are tokenized and converted in parallel, then interned and inserted in file
+ * order before the next round starts. Memory beyond the graph is thus bounded by the chunk size
+ * times the thread count, whatever the size of the file.
+ *
+ * Args:
+ *     graph (Graph&): The graph that receives the edges.
+ *     text (string_view): The contents of the edge file.
+ *     dimacs (bool): Whether the text is a DIMACS .gr file rather than a plain edge list.
+ *     numThreads (unsigned): Number of parser threads, 0 for defaultThreadCount().
+ *
+ * Throws:
+ *     runtime_error: If a line is malformed; the message names the line. Edges of earlier rounds
+ *     have already been added to the graph.
+ */
+void loadEdges(Graph& graph, string_view text, bool dimacs, unsigned numThreads = 1) {
+    const size_t BATCH_SIZE = 1 << 16;
+    const size_t CHUNK_SIZE = 1 << 22;
+    if (numThreads == 0) {
+        numThreads = defaultThreadCount();
+    }
+
+    // The DIMACS problem line announces the vertex count; interning 1..n up front makes index = id - 1.
+    size_t body = 0;
+    if (dimacs) {
+        while (body < text.size()) {
+            size_t eol = text.find('\n', body);
+            if (eol == string_view::npos) {
+                eol = text.size();
+            }
+            string_view line = text.substr(body, eol - body);
+            string_view first = nextToken(line);
+            if (first == "p") {
+                size_t n;
+                nextToken(line);
+                if (!parseNumber(nextToken(line), n)) {
+                    throw std::runtime_error("Malformed DIMACS problem line");
+                }
+                graph.keys.reserve(graph.vertList.size() + n);
+                graph.vertList.reserve(graph.vertList.size() + n);
+                for (size_t v = 1; v <= n; v++) {
+                    graph.intern(std::to_string(v));
+                }
+            } else if (!first.empty() && first != "c") {
+                break;
+            }
+            body = eol + 1;
+        }
+        body = min(body, text.size());
+    }
+
+    // Chunks are parsed a round at a time, one per thread, and each round is inserted before the
+    // next one is parsed, so at most numThreads chunks of parsed edges are held at once.
+    vector<size_t> bounds;
+    vector<vector<ParsedEdge>> parsed(numThreads);
+    vector<size_t> errors(numThreads);
+    vector<Edge> batch;
+    batch.reserve(BATCH_SIZE);
+    while (body < text.size()) {
+        bounds.assign(1, body);
+        while (bounds.size() <= numThreads && bounds.back() < text.size()) {
+            size_t eol = text.find('\n', min(bounds.back() + CHUNK_SIZE, text.size()));
+            bounds.push_back(eol == string_view::npos ? text.size() : eol + 1);
+        }
+        size_t chunks = bounds.size() - 1;
+        parallelFor(chunks, numThreads, [&](size_t begin, size_t end, unsigned) {
+            for (size_t c = begin; c < end; c++) {
+                parsed[c].clear();
+                errors[c] = parseEdgeChunk(text.substr(bounds[c], bounds[c + 1] - bounds[c]), dimacs, parsed[c]);
+            }
+        });
+        for (size_t c = 0; c < chunks; c++) {
+            if (errors[c] != string_view::npos) {
+                size_t offset = bounds[c] + errors[c];
+                size_t line = 1 + count(text.begin(), text.begin() + offset, '\n');
+                throw std::runtime_error("Malformed edge on line " + std::to_string(line));
+            }
+        }
+
+        for (size_t c = 0; c < chunks; c++) {
+            for (const ParsedEdge& edge : parsed[c]) {
+                uint32_t from = graph.intern(edge.from);
+                uint32_t to = graph.intern(edge.to);
+                batch.push_back({from, to, edge.weight});
+                if (batch.size() == BATCH_SIZE) {
+                    graph.addEdges(batch);
+                    batch.clear();
+                }
+            }
+        }
+        body = bounds.back();
+    }
+    graph.addEdges(batch);
+}
+
+/**
+ * Loads a whitespace- or comma-separated edge list file into a graph. The file is memory-mapped and
+ * parsed in place. See loadEdges for the format and the threading.
+ *
+ * Args:
+ *     graph (Graph&): The graph that receives the edges.
+ *     path (string): The edge list file.
+ *     numThreads (unsigned): Number of parser threads, 0 for defaultThreadCount().
+ *
+ * Throws:
+ *     runtime_error: If the file cannot be read or a line is malformed.
+ */
+void loadEdgeList(Graph& graph, const string& path, unsigned numThreads = 1) {
+    MappedFile file(path);
+    file.adviseSequential();
+    loadEdges(graph, string_view(file.data(), file.size()), false, numThreads);
+}
+
+/**
+ * Loads a DIMACS shortest-path (.gr) file into a graph. Vertex n of the file gets the key "n" and,
+ * in a graph that was empty, the index n - 1. See loadEdges for the format and the threading.
+ *
+ * Args:
+ *     graph (Graph&): The graph that receives the arcs.
+ *     path (string): The DIMACS file.
+ *     numThreads (unsigned): Number of parser threads, 0 for defaultThreadCount().
+ *
+ * Throws:
+ *     runtime_error: If the file cannot be read or a line is malformed.
+ */
+void loadDimacs(Graph& graph, const string& path, unsigned numThreads = 1) {
+    MappedFile file(path);
+    file.adviseSequential();
+    loadEdges(graph, string_view(file.data(), file.size()), true, numThreads);
+}
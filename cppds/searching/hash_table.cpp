@@ -1,91 +1,2702 @@
 #include <iostream>
 #include <string>
+#include <string_view> // heterogeneous lookup of string keys
+#include <cstdint>
+#include <cstring>
+#include <functional>  // std::hash, std::equal_to
+#include <memory>      // std::allocator
+#include <utility>
+#include <stdexcept>
+#include <exception>   // std::exception_ptr
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>      // std::this_thread::yield
+#include <type_traits> // std::is_trivially_copyable
+#include <cstddef>     // offsetof
+#include <cerrno>      // EINTR
+#include <cstdlib>     // mkstemp
+#include <fcntl.h>     // MappedHashTable files, POSIX only
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 using namespace std;
 
-class HashTable{
+// Hash used by HashTable when none is given. The string version is transparent: it hashes
+// anything convertible to string_view, so a lookup with a string_view or a C string does not
+// have to build a temporary string
+template<typename K>
+struct DefaultHash : hash<K> {};
+
+template<>
+struct DefaultHash<string> {
+    using is_transparent = void;
+    size_t operator()(string_view key) const {
+        return hash<string_view>()(key);
+    }
+};
+
+// Key comparison used by HashTable when none is given, transparent for strings like DefaultHash
+template<typename K>
+struct DefaultEqual : equal_to<K> {};
+
+template<>
+struct DefaultEqual<string> : equal_to<> {};
+
+// Spreads the bits of a hash value over the whole word; std::hash of an integer is often the
+// integer itself, which would leave the 7 control bits almost constant
+inline uint64_t mixHash(size_t h) {
+    uint64_t x = static_cast<uint64_t>(h) * 0x9E3779B97F4A7C15ull;
+    return x ^ (x >> 29);
+}
+
+// Control byte values. A full slot stores the low 7 bits of its hash (0..127), so the sign bit
+// alone tells full slots from free ones
+const int8_t CTRL_EMPTY = -128;
+const int8_t CTRL_DELETED = -2;
+
+// A group of control bytes that is matched in one step: 32 bytes with AVX2, 16 with SSE2, and a
+// plain loop over 16 bytes otherwise. Every match returns a bit mask with bit i set for byte i
+struct ControlGroup {
+#if defined(__AVX2__)
+    static const size_t WIDTH = 32;
+    __m256i bytes;
+
+    explicit ControlGroup(const int8_t* ctrl) : bytes(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ctrl))) {}
+
+    uint32_t match(int8_t h2) const {
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(h2))));
+    }
+
+    uint32_t matchFree() const { // empty or deleted
+        return static_cast<uint32_t>(_mm256_movemask_epi8(bytes));
+    }
+#elif defined(__SSE2__)
+    static const size_t WIDTH = 16;
+    __m128i bytes;
+
+    explicit ControlGroup(const int8_t* ctrl) : bytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+
+    uint32_t match(int8_t h2) const {
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(h2))));
+    }
+
+    uint32_t matchFree() const {
+        return static_cast<uint32_t>(_mm_movemask_epi8(bytes));
+    }
+#else
+    static const size_t WIDTH = 16;
+    int8_t bytes[WIDTH];
+
+    explicit ControlGroup(const int8_t* ctrl) {
+        memcpy(bytes, ctrl, WIDTH);
+    }
+
+    uint32_t match(int8_t h2) const {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < WIDTH; i++) {
+            mask |= static_cast<uint32_t>(bytes[i] == h2) << i;
+        }
+        return mask;
+    }
+
+    uint32_t matchFree() const {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < WIDTH; i++) {
+            mask |= static_cast<uint32_t>(bytes[i] < 0) << i;
+        }
+        return mask;
+    }
+#endif
+
+    uint32_t matchEmpty() const {
+        return match(CTRL_EMPTY);
+    }
+};
+
+// Open-addressing hash table in the style of SwissTable. The slots are split into groups of
+// ControlGroup::WIDTH, and next to the slots is an array with one control byte per slot: empty,
+// deleted, or the low 7 bits (H2) of the key's hash. A lookup hashes once, uses the high bits
+// (H1) to pick a starting group, and compares H2 against the whole group's control bytes at
+// once, so only slots whose 7 bits match are compared key by key. Groups are probed in
+// triangular order, which visits every group of a power-of-two table, and the search stops at
+// the first group with an empty slot.
+//
+// The table grows by doubling when size plus deleted slots would pass the max load factor
+// (0.875 by default). Erasing leaves a deleted marker only when the group has no empty slot,
+// because only then can a probe sequence have passed through it.
+//
+// Lookups are templated on the key type, so with a transparent Hash and Equal (the default for
+// string keys) find(string_view("cat")) works without a temporary string. Pointers returned by
+// find stay valid until the next insertion or erase.
+template<typename K = int, typename V = string, typename Hash = DefaultHash<K>, typename Equal = DefaultEqual<K>>
+class HashTable {
     public:
-    static const int size=11; // initial size of hash table is prime to help with collision resolution
-    int slots[size]; // list to hold key items
-    string data[size]; // list to hold data values
+    using value_type = pair<K, V>;
+
+    explicit HashTable(size_t capacity = 0, float maxLoad = 0.875f)
+        : ctrl(nullptr), slots(nullptr), cap(0), count(0), deleted(0), maxLoad(maxLoad) {
+        if (!(maxLoad > 0 && maxLoad < 1)) {
+            throw invalid_argument("Max load factor must be in (0, 1)");
+        }
+        reserve(capacity);
+    }
 
-    int hashfunction(int key) { // implements remainder method
-        return key%size;
+    HashTable(const HashTable& other)
+        : ctrl(nullptr), slots(nullptr), cap(0), count(0), deleted(0), maxLoad(other.maxLoad),
+          hasher(other.hasher), equal(other.equal) {
+        reserve(other.count);
+        other.for_each([this](const K& key, const V& val) { put(key, val); });
     }
 
-      // Computes original hashvalue, and if slot is
-      // not empty iterates until empty slot is found
-    int rehash(int oldhash) {
-        return (oldhash+1)%size;
+    HashTable(HashTable&& other) noexcept
+        : ctrl(other.ctrl), slots(other.slots), cap(other.cap), count(other.count), deleted(other.deleted),
+          maxLoad(other.maxLoad), hasher(move(other.hasher)), equal(move(other.equal)) {
+        other.ctrl = nullptr;
+        other.slots = nullptr;
+        other.cap = other.count = other.deleted = 0;
     }
 
-    // Function that assumes there will eventually be
-    // an empty slot unless the key is alread present in the slot
-    void put(int key, string val){
-        int hashvalue = hashfunction(key);
-        int count = 0;
+    HashTable& operator=(HashTable other) {
+        swap(ctrl, other.ctrl);
+        swap(slots, other.slots);
+        swap(cap, other.cap);
+        swap(count, other.count);
+        swap(deleted, other.deleted);
+        swap(maxLoad, other.maxLoad);
+        swap(hasher, other.hasher);
+        swap(equal, other.equal);
+        return *this;
+    }
 
-        if (data[hashvalue]=="") {
-            slots[hashvalue] = key;
-            data[hashvalue] = val;
-        } else {
-            if (slots[hashvalue] == key) {
-                data[hashvalue] = val;
-            } else {
-                int nextslot = rehash(hashvalue);
+    ~HashTable() {
+        release();
+    }
 
-                while (data[nextslot]!="" && slots[nextslot] != key) {
-                    nextslot = rehash(nextslot);
+    size_t size() const {
+        return count;
+    }
 
-                    count++;
-                    if (count>size) {
-                        cout<<"TABLE FULL"<<endl;
-                        return;
-                    }
-                }
-                if (data[nextslot]=="") {
-                    slots[nextslot]=key;
-                    data[nextslot]=val;
+    bool empty() const {
+        return count == 0;
+    }
+
+    // number of slots, always 0 or a power of two
+    size_t capacity() const {
+        return cap;
+    }
+
+    float load_factor() const {
+        return cap == 0 ? 0 : static_cast<float>(count) / cap;
+    }
+
+    float max_load_factor() const {
+        return maxLoad;
+    }
+
+    // changes the max load factor and grows right away if the table is over it
+    void max_load_factor(float f) {
+        if (!(f > 0 && f < 1)) {
+            throw invalid_argument("Max load factor must be in (0, 1)");
+        }
+        maxLoad = f;
+        if (count + deleted > maxFill(cap)) {
+            rehash(count);
+        }
+    }
+
+    // makes room for n keys without further growth
+    void reserve(size_t n) {
+        if (n > maxFill(cap)) {
+            rehash(n);
+        }
+    }
+
+    // true if one more key can be inserted without the table rehashing
+    bool has_room() const {
+        return count + deleted + 1 <= maxFill(cap);
+    }
+
+    // inserts the key or replaces its value; returns true if the key was new
+    bool put(const K& key, V val) {
+        uint64_t h = hashOf(key);
+        size_t slot = locate(key, h);
+        if (slot != NOT_FOUND) {
+            slots[slot].second = move(val);
+            return false;
+        }
+        insertNew(key, move(val), h);
+        return true;
+    }
+
+    // returns a pointer to the value of the key, or nullptr if it is not in the table
+    template<typename Q>
+    V* find(const Q& key) {
+        size_t slot = locate(key, hashOf(key));
+        return slot == NOT_FOUND ? nullptr : &slots[slot].second;
+    }
+
+    template<typename Q>
+    const V* find(const Q& key) const {
+        size_t slot = locate(key, hashOf(key));
+        return slot == NOT_FOUND ? nullptr : &slots[slot].second;
+    }
+
+    template<typename Q>
+    bool contains(const Q& key) const {
+        return find(key) != nullptr;
+    }
+
+    // returns a copy of the value of the key, or a default-constructed value (the empty string
+    // for string values) if the key is not in the table
+    template<typename Q>
+    V get(const Q& key) const {
+        const V* val = find(key);
+        return val == nullptr ? V() : *val;
+    }
+
+    // Batched lookup: out[i] is set to a pointer to the value of keys[i], or nullptr. The keys
+    // are handled BATCH at a time in three passes: hash them all and prefetch their home
+    // groups' control bytes, then match H2 and prefetch the first candidate slot, then resolve
+    // the probes. The cache misses of a batch overlap instead of being taken one after another,
+    // which pays off once the table is much bigger than the cache. Returns the number of keys
+    // found.
+    template<typename Q>
+    size_t find_batch(const Q* keys, size_t n, const V** out) const {
+        size_t found = 0;
+        uint64_t hashes[BATCH];
+        for (size_t i = 0; i < n; i += BATCH) {
+            size_t m = min(BATCH, n - i);
+            for (size_t j = 0; j < m; j++) {
+                hashes[j] = hashOf(keys[i + j]);
+                prefetchGroup(hashes[j]);
+            }
+            for (size_t j = 0; j < m; j++) {
+                prefetchCandidate(hashes[j]);
+            }
+            for (size_t j = 0; j < m; j++) {
+                size_t slot = locate(keys[i + j], hashes[j]);
+                out[i + j] = slot == NOT_FOUND ? nullptr : &slots[slot].second;
+                found += slot != NOT_FOUND;
+            }
+        }
+        return found;
+    }
+
+    // batched get: out[i] is a copy of the value of keys[i], or V() if it is not in the table
+    template<typename Q>
+    size_t get_batch(const Q* keys, size_t n, V* out) const {
+        size_t found = 0;
+        const V* vals[BATCH];
+        for (size_t i = 0; i < n; i += BATCH) {
+            size_t m = min(BATCH, n - i);
+            found += find_batch(keys + i, m, vals);
+            for (size_t j = 0; j < m; j++) {
+                out[i + j] = vals[j] == nullptr ? V() : *vals[j];
+            }
+        }
+        return found;
+    }
+
+    template<typename Q>
+    vector<V> get_batch(const vector<Q>& keys) const {
+        vector<V> vals(keys.size());
+        get_batch(keys.data(), keys.size(), vals.data());
+        return vals;
+    }
+
+    // Batched put with the same prefetching as find_batch. The table first makes room for all
+    // n entries, so nothing rehashes in the middle of a batch (if many keys are already present
+    // this can grow the table one step earlier than single puts would). Entries are applied in
+    // order, so a key repeated in the batch ends up with its last value. Returns the number of
+    // new keys.
+    size_t put_batch(const value_type* entries, size_t n) {
+        if (count + deleted + n > maxFill(cap)) {
+            rehash(count + n);
+        }
+        size_t added = 0;
+        uint64_t hashes[BATCH];
+        for (size_t i = 0; i < n; i += BATCH) {
+            size_t m = min(BATCH, n - i);
+            for (size_t j = 0; j < m; j++) {
+                hashes[j] = hashOf(entries[i + j].first);
+                prefetchGroup(hashes[j]);
+            }
+            for (size_t j = 0; j < m; j++) {
+                prefetchCandidate(hashes[j]);
+            }
+            for (size_t j = 0; j < m; j++) {
+                const value_type& entry = entries[i + j];
+                size_t slot = locate(entry.first, hashes[j]);
+                if (slot != NOT_FOUND) {
+                    slots[slot].second = entry.second;
                 } else {
-                    data[nextslot] = val;
+                    insertNew(entry.first, V(entry.second), hashes[j]);
+                    added++;
                 }
             }
         }
+        return added;
     }
 
-    // computes the initial hash value
-    // if value is not in the initial slot, uses
-    // rehash to locate the next position
-    string get(int key) {
-        int startslot = hashfunction(key);
+    size_t put_batch(const vector<value_type>& entries) {
+        return put_batch(entries.data(), entries.size());
+    }
 
-        string val;
-        bool stop=false;
-        bool found=false;
-        int position = startslot;
-        while(data[position]!="" && !found && !stop) {
-            if (slots[position]==key) {
-                found = true;
-                val = data[position];
-            } else {
-                position=rehash(position);
-                if (position==startslot) {
-                    stop=true;
+    // removes the key; returns true if it was in the table
+    template<typename Q>
+    bool erase(const Q& key) {
+        size_t slot = locate(key, hashOf(key));
+        if (slot == NOT_FOUND) {
+            return false;
+        }
+        slots[slot].~value_type();
+        ControlGroup group(ctrl + (slot & ~(ControlGroup::WIDTH - 1)));
+        if (group.matchEmpty() != 0) {
+            ctrl[slot] = CTRL_EMPTY;
+        } else {
+            ctrl[slot] = CTRL_DELETED;
+            deleted++;
+        }
+        count--;
+        return true;
+    }
+
+    void clear() {
+        for (size_t i = 0; i < cap; i++) {
+            if (ctrl[i] >= 0) {
+                slots[i].~value_type();
+            }
+        }
+        memset(ctrl, CTRL_EMPTY, cap);
+        count = deleted = 0;
+    }
+
+    // calls f(key, value) for every entry, in slot order
+    template<typename Function>
+    void for_each(Function f) const {
+        for (size_t i = 0; i < cap; i++) {
+            if (ctrl[i] >= 0) {
+                f(slots[i].first, slots[i].second);
+            }
+        }
+    }
+
+    friend ostream& operator<<(ostream& stream, const HashTable& table) {
+        table.for_each([&stream](const K& key, const V& val) {
+            stream << key << ": " << val << endl;
+        });
+        return stream;
+    }
+
+    private:
+    static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+    static constexpr size_t BATCH = 16; // keys in flight per batch pass
+
+    int8_t* ctrl;        // one control byte per slot
+    value_type* slots;   // raw storage, an entry is constructed only where ctrl is full
+    size_t cap;
+    size_t count;
+    size_t deleted;      // slots marked CTRL_DELETED, counted against the load factor
+    float maxLoad;
+    Hash hasher;
+    Equal equal;
+
+    size_t maxFill(size_t capacity) const {
+        return static_cast<size_t>(capacity * maxLoad);
+    }
+
+    template<typename Q>
+    uint64_t hashOf(const Q& key) const {
+        return mixHash(hasher(key));
+    }
+
+    // index of the slot holding the key, or NOT_FOUND
+    template<typename Q>
+    size_t locate(const Q& key, uint64_t h) const {
+        if (cap == 0) {
+            return NOT_FOUND;
+        }
+        size_t groupMask = cap / ControlGroup::WIDTH - 1;
+        size_t g = static_cast<size_t>(h >> 7) & groupMask;
+        int8_t h2 = static_cast<int8_t>(h & 0x7F);
+        for (size_t step = 1; step <= groupMask + 1; step++) {
+            size_t base = g * ControlGroup::WIDTH;
+            ControlGroup group(ctrl + base);
+            for (uint32_t mask = group.match(h2); mask != 0; mask &= mask - 1) {
+                size_t slot = base + __builtin_ctz(mask);
+                if (equal(slots[slot].first, key)) {
+                    return slot;
                 }
             }
+            if (group.matchEmpty() != 0) {
+                return NOT_FOUND;
+            }
+            g = (g + step) & groupMask;
+        }
+        return NOT_FOUND;
+    }
 
+    // prefetches the control bytes of the home group of h
+    void prefetchGroup(uint64_t h) const {
+        if (cap > 0) {
+            size_t g = static_cast<size_t>(h >> 7) & (cap / ControlGroup::WIDTH - 1);
+            __builtin_prefetch(ctrl + g * ControlGroup::WIDTH);
+        }
+    }
+
+    // prefetches the first slot of the home group whose H2 matches h, if there is one
+    void prefetchCandidate(uint64_t h) const {
+        if (cap > 0) {
+            size_t g = static_cast<size_t>(h >> 7) & (cap / ControlGroup::WIDTH - 1);
+            size_t base = g * ControlGroup::WIDTH;
+            uint32_t mask = ControlGroup(ctrl + base).match(static_cast<int8_t>(h & 0x7F));
+            if (mask != 0) {
+                __builtin_prefetch(&slots[base + __builtin_ctz(mask)]);
+            }
+        }
+    }
+
+    // first empty or deleted slot on the probe sequence of h; the table must have one
+    size_t freeSlot(uint64_t h) const {
+        size_t groupMask = cap / ControlGroup::WIDTH - 1;
+        size_t g = static_cast<size_t>(h >> 7) & groupMask;
+        for (size_t step = 1; ; step++) {
+            uint32_t mask = ControlGroup(ctrl + g * ControlGroup::WIDTH).matchFree();
+            if (mask != 0) {
+                return g * ControlGroup::WIDTH + __builtin_ctz(mask);
+            }
+            g = (g + step) & groupMask;
+        }
+    }
+
+    // inserts a key known to be absent
+    void insertNew(const K& key, V&& val, uint64_t h) {
+        if (count + deleted + 1 > maxFill(cap)) {
+            rehash(count + 1);
+        }
+        size_t slot = freeSlot(h);
+        if (ctrl[slot] == CTRL_DELETED) {
+            deleted--;
+        }
+        new (&slots[slot]) value_type(key, move(val));
+        ctrl[slot] = static_cast<int8_t>(h & 0x7F);
+        count++;
+    }
+
+    // moves every entry into a new table with room for n keys, dropping deleted markers
+    void rehash(size_t n) {
+        size_t newCap = ControlGroup::WIDTH;
+        while (maxFill(newCap) < n) {
+            newCap *= 2;
+        }
+        int8_t* oldCtrl = ctrl;
+        value_type* oldSlots = slots;
+        size_t oldCap = cap;
+        ctrl = new int8_t[newCap];
+        memset(ctrl, CTRL_EMPTY, newCap);
+        slots = allocator<value_type>().allocate(newCap);
+        cap = newCap;
+        deleted = 0;
+        for (size_t i = 0; i < oldCap; i++) {
+            if (oldCtrl[i] >= 0) {
+                uint64_t h = hashOf(oldSlots[i].first);
+                size_t slot = freeSlot(h);
+                new (&slots[slot]) value_type(move(oldSlots[i]));
+                ctrl[slot] = static_cast<int8_t>(h & 0x7F);
+                oldSlots[i].~value_type();
+            }
+        }
+        if (oldCap > 0) {
+            delete[] oldCtrl;
+            allocator<value_type>().deallocate(oldSlots, oldCap);
+        }
+    }
+
+    void release() {
+        if (cap > 0) {
+            clear();
+            delete[] ctrl;
+            allocator<value_type>().deallocate(slots, cap);
+        }
+        ctrl = nullptr;
+        slots = nullptr;
+        cap = count = deleted = 0;
+    }
+};
+
+// Open-addressing hash table with Robin Hood linear probing, the alternative to HashTable for
+// churn-heavy workloads; it has the same interface. Every slot stores its entry's probe distance
+// (how far it sits from its home slot, plus one so that 0 means empty). An insert that meets an
+// entry closer to home than itself takes that slot and carries the displaced entry on, so probe
+// distances stay short and even. A lookup stops as soon as it reaches a slot whose entry is
+// closer to home than the key would be, which bounds the cost of a miss.
+//
+// erase uses backward-shift deletion: the entries after the removed one move back one slot
+// until an empty slot or an entry already at home, so no tombstones are left behind and a table
+// that sees many inserts and erases never degrades. Probe distances are kept below 255; an
+// insert that would go further grows the table.
+template<typename K = int, typename V = string, typename Hash = DefaultHash<K>, typename Equal = DefaultEqual<K>>
+class RobinHoodHashTable {
+    public:
+    using value_type = pair<K, V>;
+
+    explicit RobinHoodHashTable(size_t capacity = 0, float maxLoad = 0.875f)
+        : distance(nullptr), slots(nullptr), cap(0), shift(64), count(0), maxLoad(maxLoad) {
+        if (!(maxLoad > 0 && maxLoad < 1)) {
+            throw invalid_argument("Max load factor must be in (0, 1)");
+        }
+        reserve(capacity);
+    }
+
+    RobinHoodHashTable(const RobinHoodHashTable& other)
+        : distance(nullptr), slots(nullptr), cap(0), shift(64), count(0), maxLoad(other.maxLoad),
+          hasher(other.hasher), equal(other.equal) {
+        reserve(other.count);
+        other.for_each([this](const K& key, const V& val) { put(key, val); });
+    }
+
+    RobinHoodHashTable(RobinHoodHashTable&& other) noexcept
+        : distance(other.distance), slots(other.slots), cap(other.cap), shift(other.shift), count(other.count),
+          maxLoad(other.maxLoad), hasher(move(other.hasher)), equal(move(other.equal)) {
+        other.distance = nullptr;
+        other.slots = nullptr;
+        other.cap = other.count = 0;
+        other.shift = 64;
+    }
+
+    RobinHoodHashTable& operator=(RobinHoodHashTable other) {
+        swap(distance, other.distance);
+        swap(slots, other.slots);
+        swap(cap, other.cap);
+        swap(shift, other.shift);
+        swap(count, other.count);
+        swap(maxLoad, other.maxLoad);
+        swap(hasher, other.hasher);
+        swap(equal, other.equal);
+        return *this;
+    }
+
+    ~RobinHoodHashTable() {
+        release();
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    // number of slots, always 0 or a power of two
+    size_t capacity() const {
+        return cap;
+    }
+
+    float load_factor() const {
+        return cap == 0 ? 0 : static_cast<float>(count) / cap;
+    }
+
+    float max_load_factor() const {
+        return maxLoad;
+    }
+
+    void max_load_factor(float f) {
+        if (!(f > 0 && f < 1)) {
+            throw invalid_argument("Max load factor must be in (0, 1)");
+        }
+        maxLoad = f;
+        if (count > maxFill(cap)) {
+            rehash(count, false);
+        }
+    }
+
+    void reserve(size_t n) {
+        if (n > maxFill(cap)) {
+            rehash(n, false);
+        }
+    }
+
+    // inserts the key or replaces its value; returns true if the key was new
+    bool put(const K& key, V val) {
+        uint64_t h = mixHash(hasher(key));
+        size_t slot = locate(key, h);
+        if (slot != NOT_FOUND) {
+            slots[slot].second = move(val);
+            return false;
+        }
+        if (count + 1 > maxFill(cap)) {
+            rehash(count + 1, false);
+        }
+        size_t pos, end;
+        uint8_t d;
+        while (!findInsertion(distance, h, pos, d, end)) {
+            // A probe would get too long: double the table, up to MAX_GROWTH times the normal size
+            if (cap >= minCapacity(count + 1) * MAX_GROWTH) {
+                throw length_error("Hash function puts too many keys in one place");
+            }
+            rehash(count + 1, true);
+        }
+        // Shift the run [pos, end) one slot forward, which keeps it in Robin Hood order
+        size_t mask = cap - 1;
+        if (end != pos) {
+            size_t prev = (end - 1) & mask;
+            new (&slots[end]) value_type(move(slots[prev]));
+            distance[end] = distance[prev] + 1;
+            for (size_t j = prev; j != pos; j = prev) {
+                prev = (j - 1) & mask;
+                slots[j] = move(slots[prev]);
+                distance[j] = distance[prev] + 1;
+            }
+            slots[pos] = value_type(key, move(val));
+        } else {
+            new (&slots[pos]) value_type(key, move(val));
+        }
+        distance[pos] = d;
+        count++;
+        return true;
+    }
+
+    template<typename Q>
+    V* find(const Q& key) {
+        size_t slot = locate(key, mixHash(hasher(key)));
+        return slot == NOT_FOUND ? nullptr : &slots[slot].second;
+    }
+
+    template<typename Q>
+    const V* find(const Q& key) const {
+        size_t slot = locate(key, mixHash(hasher(key)));
+        return slot == NOT_FOUND ? nullptr : &slots[slot].second;
+    }
+
+    template<typename Q>
+    bool contains(const Q& key) const {
+        return find(key) != nullptr;
+    }
+
+    // returns a copy of the value of the key, or a default-constructed value if it is absent
+    template<typename Q>
+    V get(const Q& key) const {
+        const V* val = find(key);
+        return val == nullptr ? V() : *val;
+    }
+
+    // removes the key with backward-shift deletion; returns true if it was in the table
+    template<typename Q>
+    bool erase(const Q& key) {
+        size_t slot = locate(key, mixHash(hasher(key)));
+        if (slot == NOT_FOUND) {
+            return false;
+        }
+        size_t mask = cap - 1;
+        size_t next = (slot + 1) & mask;
+        while (distance[next] > 1) {
+            slots[slot] = move(slots[next]);
+            distance[slot] = distance[next] - 1;
+            slot = next;
+            next = (next + 1) & mask;
+        }
+        slots[slot].~value_type();
+        distance[slot] = 0;
+        count--;
+        return true;
+    }
+
+    void clear() {
+        for (size_t i = 0; i < cap; i++) {
+            if (distance[i] != 0) {
+                slots[i].~value_type();
+                distance[i] = 0;
+            }
+        }
+        count = 0;
+    }
+
+    // the longest probe distance in the table, for measurement
+    size_t max_probe_length() const {
+        uint8_t longest = 0;
+        for (size_t i = 0; i < cap; i++) {
+            longest = max(longest, distance[i]);
+        }
+        return longest == 0 ? 0 : longest - 1;
+    }
+
+    // calls f(key, value) for every entry, in slot order
+    template<typename Function>
+    void for_each(Function f) const {
+        for (size_t i = 0; i < cap; i++) {
+            if (distance[i] != 0) {
+                f(slots[i].first, slots[i].second);
+            }
+        }
+    }
+
+    friend ostream& operator<<(ostream& stream, const RobinHoodHashTable& table) {
+        table.for_each([&stream](const K& key, const V& val) {
+            stream << key << ": " << val << endl;
+        });
+        return stream;
+    }
+
+    private:
+    static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+    static const uint8_t MAX_DISTANCE = 255;
+    static const size_t MAX_GROWTH = 8;  // how far past its normal size a table grows to shorten probes
+
+    uint8_t* distance;   // probe distance + 1 of every slot, 0 for empty
+    value_type* slots;   // raw storage, an entry is constructed only where distance is nonzero
+    size_t cap;
+    unsigned shift;      // 64 - log2(cap): the home slot is the top bits of the hash
+    size_t count;
+    float maxLoad;
+    Hash hasher;
+    Equal equal;
+
+    size_t maxFill(size_t capacity) const {
+        return static_cast<size_t>(capacity * maxLoad);
+    }
+
+    // smallest table that holds n keys within the max load factor
+    size_t minCapacity(size_t n) const {
+        size_t c = 16;
+        while (maxFill(c) < n) {
+            c *= 2;
+        }
+        return c;
+    }
+
+    size_t home(uint64_t h) const {
+        return static_cast<size_t>(h >> shift);
+    }
+
+    template<typename Q>
+    size_t locate(const Q& key, uint64_t h) const {
+        if (cap == 0) {
+            return NOT_FOUND;
+        }
+        size_t mask = cap - 1;
+        size_t slot = home(h);
+        // Stop at an empty slot or at an entry closer to its home than the key would be
+        for (unsigned d = 1; distance[slot] >= d; d++) {
+            if (distance[slot] == d && equal(slots[slot].first, key)) {
+                return slot;
+            }
+            slot = (slot + 1) & mask;
+        }
+        return NOT_FOUND;
+    }
+
+    // Finds where a new key with hash h goes in a table with the given distances: slot pos,
+    // reached at probe distance d, and the first empty slot end at or after pos. Returns false
+    // if the key or an entry it pushes forward would reach MAX_DISTANCE
+    bool findInsertion(const uint8_t* dist, uint64_t h, size_t& pos, uint8_t& d, size_t& end) const {
+        size_t mask = cap - 1;
+        pos = home(h);
+        for (d = 1; dist[pos] >= d; d++) {
+            if (d + 1 == MAX_DISTANCE) {
+                return false;
+            }
+            pos = (pos + 1) & mask;
+        }
+        for (end = pos; dist[end] != 0; end = (end + 1) & mask) {
+            if (dist[end] + 1 == MAX_DISTANCE) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // moves every entry into a table with room for n keys, at least twice the current size when
+    // grow is set. The layout is planned on entry indices first, so if the hash is too poor to
+    // keep probe distances below MAX_DISTANCE even in a much larger table, length_error is
+    // thrown and the table is left as it was
+    void rehash(size_t n, bool grow) {
+        size_t newCap = minCapacity(n);
+        size_t limit = newCap * MAX_GROWTH;
+        while (grow && newCap <= cap) {
+            newCap *= 2;
+        }
+        limit = max(limit, newCap);
+        vector<uint64_t> hashes(cap);
+        for (size_t i = 0; i < cap; i++) {
+            if (distance[i] != 0) {
+                hashes[i] = mixHash(hasher(slots[i].first));
+            }
+        }
+
+        uint8_t* oldDistance = distance;
+        size_t oldCap = cap;
+        unsigned oldShift = shift;
+        vector<size_t> source;  // source[j]: old slot of the entry planned for new slot j
+        uint8_t* newDistance = nullptr;
+        for (;;) {
+            if (newCap > limit) {
+                delete[] newDistance;
+                distance = oldDistance;
+                cap = oldCap;
+                shift = oldShift;
+                throw length_error("Hash function puts too many keys in one place");
+            }
+            delete[] newDistance;
+            newDistance = new uint8_t[newCap]();
+            source.assign(newCap, NOT_FOUND);
+            distance = newDistance;  // findInsertion and home() use the new geometry
+            cap = newCap;
+            shift = 64 - __builtin_ctzll(newCap);
+            bool fits = true;
+            for (size_t i = 0; i < oldCap && fits; i++) {
+                if (oldDistance[i] == 0) {
+                    continue;
+                }
+                size_t pos, end;
+                uint8_t d;
+                fits = findInsertion(newDistance, hashes[i], pos, d, end);
+                if (fits) {
+                    for (size_t j = end; j != pos; j = (j - 1) & (newCap - 1)) {
+                        size_t prev = (j - 1) & (newCap - 1);
+                        source[j] = source[prev];
+                        newDistance[j] = newDistance[prev] + 1;
+                    }
+                    source[pos] = i;
+                    newDistance[pos] = d;
+                }
+            }
+            if (fits) {
+                break;
+            }
+            newCap *= 2;
+        }
+
+        value_type* oldSlots = slots;
+        slots = allocator<value_type>().allocate(newCap);
+        for (size_t j = 0; j < newCap; j++) {
+            if (source[j] != NOT_FOUND) {
+                new (&slots[j]) value_type(move(oldSlots[source[j]]));
+                oldSlots[source[j]].~value_type();
+            }
+        }
+        if (oldCap > 0) {
+            delete[] oldDistance;
+            allocator<value_type>().deallocate(oldSlots, oldCap);
         }
-        return val;
     }
 
-    friend ostream& operator<<(ostream& stream, HashTable& hash);
+    void release() {
+        if (cap > 0) {
+            clear();
+            delete[] distance;
+            allocator<value_type>().deallocate(slots, cap);
+        }
+        distance = nullptr;
+        slots = nullptr;
+        cap = count = 0;
+        shift = 64;
+    }
 };
 
+// Epoch-based reclamation shared by all ConcurrentHashMaps. A thread that reads without a lock
+// first announces the current epoch in its own slot and clears the slot when done. Memory
+// retired at epoch e can be freed once no slot announces an epoch e or older, because every
+// reader that started later already sees the replacement. Threads get a slot the first time
+// they read and give it back when they exit; beyond MAX_READERS concurrent threads, readers fall
+// back to the shard lock
+class EpochDomain {
+    public:
+    static const size_t MAX_READERS = 256;
+    static constexpr size_t NO_SLOT = static_cast<size_t>(-1);
+
+    static EpochDomain& instance() {
+        static EpochDomain domain;
+        return domain;
+    }
+
+    // slot of the calling thread, or NO_SLOT if all are taken
+    size_t slot() {
+        thread_local SlotHandle handle(*this);
+        return handle.index;
+    }
+
+    void enter(size_t slot) {
+        slots[slot].epoch.store(global.load());
+    }
+
+    void leave(size_t slot) {
+        slots[slot].epoch.store(0);
+    }
 
+    // starts a new epoch and returns the one that just ended, to tag retired memory with
+    uint64_t advance() {
+        return global.fetch_add(1);
+    }
 
-ostream& operator<<(ostream& stream, HashTable& hash) {
-    for (int i=0; i<hash.size; i++) {
-        stream<<hash.slots[i]<<": "<<hash.data[i]<<endl;
+    // true if nothing retired at epoch e can still be in use
+    bool safe(uint64_t e) const {
+        for (size_t i = 0; i < MAX_READERS; i++) {
+            uint64_t announced = slots[i].epoch.load();
+            if (announced != 0 && announced <= e) {
+                return false;
+            }
+        }
+        return true;
     }
 
-    return stream;
-}
\ No newline at end of file
+    private:
+    struct alignas(64) Slot {
+        atomic<uint64_t> epoch{0};  // 0 while the thread is not reading
+        atomic<bool> used{false};
+    };
+
+    struct SlotHandle {
+        EpochDomain& domain;
+        size_t index;
+
+        explicit SlotHandle(EpochDomain& domain) : domain(domain), index(NO_SLOT) {
+            for (size_t i = 0; i < MAX_READERS; i++) {
+                bool expected = false;
+                if (domain.slots[i].used.compare_exchange_strong(expected, true)) {
+                    index = i;
+                    break;
+                }
+            }
+        }
+
+        ~SlotHandle() {
+            if (index != NO_SLOT) {
+                domain.slots[index].used.store(false);
+            }
+        }
+    };
+
+    Slot slots[MAX_READERS];
+    atomic<uint64_t> global{1};
+
+    EpochDomain() {}
+};
+
+// Hash map for many threads, built from HashTable shards selected by the top bits of the hash.
+// Writers lock one shard. When K and V are trivially copyable, find does not lock at all: each
+// shard has a sequence counter that writers make odd while they change the table, and a reader
+// copies the value and retries if the counter moved (a seqlock). A shard that has to grow
+// builds a bigger table on the side and publishes it with one pointer store, so readers and
+// writers of other shards never wait for a resize; the old table is freed through EpochDomain
+// once no reader can still see it. Other key and value types are read under a shared lock.
+template<typename K, typename V, typename Hash = DefaultHash<K>, typename Equal = DefaultEqual<K>>
+class ConcurrentHashMap {
+    public:
+    using Table = HashTable<K, V, Hash, Equal>;
+
+    // numShards is rounded up to a power of two; capacity is spread over the shards
+    explicit ConcurrentHashMap(size_t numShards = 64, size_t capacity = 0) : shardBits(0) {
+        while ((size_t(1) << shardBits) < max<size_t>(numShards, 1)) {
+            shardBits++;
+        }
+        shards = vector<Shard>(size_t(1) << shardBits);
+        for (Shard& shard : shards) {
+            shard.table.store(new Table(capacity >> shardBits));
+        }
+    }
+
+    ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+    ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+    ~ConcurrentHashMap() {
+        for (Shard& shard : shards) {
+            delete shard.table.load();
+        }
+        for (auto& item : retired) {
+            delete item.second;
+        }
+    }
+
+    // inserts the key or replaces its value; returns true if the key was new
+    bool insert_or_assign(const K& key, V val) {
+        Shard& shard = shardOf(key);
+        unique_lock<shared_mutex> lock(shard.lock);
+        Table* table = shard.table.load();
+        V* current = table->find(key);
+        if (current != nullptr) {
+            beginWrite(shard);
+            *current = move(val);
+            endWrite(shard);
+            return false;
+        }
+        if (table->has_room()) {
+            beginWrite(shard);
+            table->put(key, move(val));
+            endWrite(shard);
+        } else {
+            // Grow on the side; readers keep using the old table until the pointer switches
+            Table* bigger = new Table(max<size_t>(2 * table->size(), 16), table->max_load_factor());
+            table->for_each([bigger](const K& k, const V& v) { bigger->put(k, v); });
+            bigger->put(key, move(val));
+            shard.table.store(bigger);
+            retire(table);
+        }
+        shard.count.fetch_add(1, memory_order_relaxed);
+        return true;
+    }
+
+    // copies the value of the key into out; returns false if the key is absent
+    template<typename Q>
+    bool find(const Q& key, V& out) const {
+        const Shard& shard = shardOf(key);
+        if constexpr (OPTIMISTIC) {
+            int found = findOptimistic(shard, key, out);
+            if (found >= 0) {
+                return found == 1;
+            }
+        }
+        shared_lock<shared_mutex> lock(shard.lock);
+        const V* val = shard.table.load()->find(key);
+        if (val == nullptr) {
+            return false;
+        }
+        out = *val;
+        return true;
+    }
+
+    template<typename Q>
+    bool contains(const Q& key) const {
+        V ignored;
+        return find(key, ignored);
+    }
+
+    // removes the key; returns true if it was in the map
+    template<typename Q>
+    bool erase(const Q& key) {
+        Shard& shard = shardOf(key);
+        unique_lock<shared_mutex> lock(shard.lock);
+        Table* table = shard.table.load();
+        if (table->find(key) == nullptr) {
+            return false;
+        }
+        beginWrite(shard);
+        table->erase(key);
+        endWrite(shard);
+        shard.count.fetch_sub(1, memory_order_relaxed);
+        return true;
+    }
+
+    // number of keys; only exact when no thread is writing
+    size_t size() const {
+        size_t total = 0;
+        for (const Shard& shard : shards) {
+            total += shard.count.load(memory_order_relaxed);
+        }
+        return total;
+    }
+
+    size_t shard_count() const {
+        return shards.size();
+    }
+
+    // calls f(key, value) for every entry, holding one shard's lock at a time
+    template<typename Function>
+    void for_each(Function f) const {
+        for (const Shard& shard : shards) {
+            shared_lock<shared_mutex> lock(shard.lock);
+            shard.table.load()->for_each(f);
+        }
+    }
+
+    private:
+    // Lock-free reads copy keys and values that a writer may be changing, which is only
+    // harmless for plain bytes
+    static constexpr bool OPTIMISTIC = is_trivially_copyable<K>::value && is_trivially_copyable<V>::value;
+    static const int OPTIMISTIC_ATTEMPTS = 8;
+
+    struct alignas(64) Shard {
+        mutable shared_mutex lock;
+        atomic<uint64_t> version{0};  // odd while a writer changes the table in place
+        atomic<Table*> table{nullptr};
+        atomic<size_t> count{0};
+    };
+
+    vector<Shard> shards;
+    unsigned shardBits;
+    Hash hasher;
+    mutex retireLock;
+    vector<pair<uint64_t, Table*>> retired;  // replaced tables and the epoch they were replaced in
+
+    template<typename Q>
+    Shard& shardOf(const Q& key) {
+        return shards[shardBits == 0 ? 0 : mixHash(hasher(key)) >> (64 - shardBits)];
+    }
+
+    template<typename Q>
+    const Shard& shardOf(const Q& key) const {
+        return shards[shardBits == 0 ? 0 : mixHash(hasher(key)) >> (64 - shardBits)];
+    }
+
+    // seqlock read under an epoch guard: 1 if found, 0 if absent, -1 if writers kept the shard
+    // busy (or the thread has no epoch slot) and the caller should take the lock
+    template<typename Q>
+    int findOptimistic(const Shard& shard, const Q& key, V& out) const {
+        EpochDomain& epochs = EpochDomain::instance();
+        size_t slot = epochs.slot();
+        if (slot == EpochDomain::NO_SLOT) {
+            return -1;
+        }
+        epochs.enter(slot);
+        int result = -1;
+        for (int attempt = 0; attempt < OPTIMISTIC_ATTEMPTS && result < 0; attempt++) {
+            uint64_t before = shard.version.load(memory_order_acquire);
+            if (before & 1) {
+                this_thread::yield();
+                continue;
+            }
+            const V* val = shard.table.load()->find(key);
+            V copy;
+            if (val != nullptr) {
+                memcpy(&copy, val, sizeof(V));
+            }
+            atomic_thread_fence(memory_order_acquire);
+            if (shard.version.load(memory_order_relaxed) == before) {
+                if (val != nullptr) {
+                    out = copy;
+                }
+                result = val != nullptr;
+            }
+        }
+        epochs.leave(slot);
+        return result;
+    }
+
+    static void beginWrite(Shard& shard) {
+        shard.version.store(shard.version.load(memory_order_relaxed) + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+    }
+
+    static void endWrite(Shard& shard) {
+        shard.version.store(shard.version.load(memory_order_relaxed) + 1, memory_order_release);
+    }
+
+    // frees the table once no reader can see it, along with older ones that became safe
+    void retire(Table* table) {
+        EpochDomain& epochs = EpochDomain::instance();
+        lock_guard<mutex> lock(retireLock);
+        retired.push_back(make_pair(epochs.advance(), table));
+        size_t kept = 0;
+        for (auto& item : retired) {
+            if (epochs.safe(item.first)) {
+                delete item.second;
+            } else {
+                retired[kept++] = item;
+            }
+        }
+        retired.resize(kept);
+    }
+};
+
+// Read-only hash table over a fixed key set, built on a minimal perfect hash in the style of
+// PTHash: every key maps to its own index in [0, n), so the entries sit in one dense
+// array with no empty slots, and a lookup reads one pilot and then compares exactly one key.
+// The key set is split into partitions of about PARTITION_KEYS keys by the high hash bits. Each
+// partition hashes its keys into buckets of about BUCKET_KEYS keys, and every bucket gets a
+// pilot, the first number p for which all of its keys land on distinct free indexes of the
+// partition when their hash is remixed with p. Buckets are placed largest first, while the
+// partition is still mostly empty. To keep the last buckets cheap, the pilots hash into 1% more
+// positions than there are keys, and the few keys that land past the end are remapped into the
+// holes below it. A pilot takes 16 bits, under 6 bits per key in all.
+//
+// Partitions are independent, so they are built in parallel (numThreads = 0 means one thread
+// per core). Duplicate keys, and distinct keys whose 64-bit hashes collide, make construction
+// throw invalid_argument.
+template<typename K = int, typename V = string, typename Hash = DefaultHash<K>, typename Equal = DefaultEqual<K>>
+class FrozenHashTable {
+    public:
+    using value_type = pair<K, V>;
+
+    explicit FrozenHashTable(vector<value_type> entries, unsigned numThreads = 0) {
+        build(entries, numThreads);
+    }
+
+    explicit FrozenHashTable(const HashTable<K, V, Hash, Equal>& table, unsigned numThreads = 0) {
+        vector<value_type> entries;
+        entries.reserve(table.size());
+        table.for_each([&entries](const K& key, const V& val) { entries.emplace_back(key, val); });
+        build(entries, numThreads);
+    }
+
+    size_t size() const {
+        return slots.size();
+    }
+
+    bool empty() const {
+        return slots.empty();
+    }
+
+    // index of the key in [0, size()), or size() if it is not in the table
+    template<typename Q>
+    size_t index_of(const Q& key) const {
+        if (slots.empty()) {
+            return slots.size();
+        }
+        uint64_t h = remix(hasher(key));
+        const Partition& part = partitions[reduce(h >> 32, partitions.size())];
+        if (part.size == 0) {
+            return slots.size();
+        }
+        uint16_t pilot = pilots[part.pilots + reduce(h & 0xFFFFFFFF, part.buckets)];
+        size_t pos = position(h, part.seed, pilot, part.range);
+        if (pos >= part.size) {
+            pos = remap[part.remap + pos - part.size];
+        }
+        size_t index = part.offset + pos;
+        return equal(slots[index].first, key) ? index : slots.size();
+    }
+
+    template<typename Q>
+    const V* find(const Q& key) const {
+        size_t index = index_of(key);
+        return index == slots.size() ? nullptr : &slots[index].second;
+    }
+
+    template<typename Q>
+    bool contains(const Q& key) const {
+        return find(key) != nullptr;
+    }
+
+    template<typename Q>
+    V get(const Q& key) const {
+        const V* val = find(key);
+        return val == nullptr ? V() : *val;
+    }
+
+    // entry at an index returned by index_of
+    const value_type& at(size_t index) const {
+        return slots[index];
+    }
+
+    // calls f(key, value) for every entry, in index order
+    template<typename Function>
+    void for_each(Function f) const {
+        for (const value_type& slot : slots) {
+            f(slot.first, slot.second);
+        }
+    }
+
+    friend ostream& operator<<(ostream& stream, const FrozenHashTable& table) {
+        table.for_each([&stream](const K& key, const V& val) {
+            stream << key << ": " << val << endl;
+        });
+        return stream;
+    }
+
+    private:
+    static constexpr size_t PARTITION_KEYS = 1 << 16;
+    static constexpr size_t BUCKET_KEYS = 3;
+    static constexpr uint32_t MAX_PILOT = 0xFFFF;
+
+    struct Partition {
+        size_t offset;   // first index of the partition
+        size_t pilots;   // first pilot of the partition
+        size_t remap;    // first remapped position of the partition
+        uint32_t size;
+        uint32_t range;  // positions the pilots hash into, a little more than size
+        uint32_t buckets;
+        uint32_t seed;   // picks another family of positions if the pilots did not fit
+    };
+
+    vector<Partition> partitions;
+    vector<uint16_t> pilots;
+    vector<uint32_t> remap;   // free index below size for each position at or above it
+    vector<value_type> slots; // the entry whose key has index i is at i
+    Hash hasher;
+    Equal equal;
+
+    // the murmur3 finalizer; stronger than mixHash, since every bit of the result is used
+    static uint64_t remix(uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xFF51AFD7ED558CCDull;
+        x ^= x >> 33;
+        x *= 0xC4CEB9FE1A85EC53ull;
+        return x ^ (x >> 33);
+    }
+
+    // maps a 32-bit value onto [0, n) with a multiply instead of a division
+    static size_t reduce(uint64_t x, size_t n) {
+        return static_cast<size_t>((x * n) >> 32);
+    }
+
+    static size_t position(uint64_t h, uint32_t seed, uint32_t pilot, uint32_t range) {
+        uint64_t p = static_cast<uint64_t>(seed) << 16 | pilot;
+        return reduce(((h ^ (p * 0x9E3779B97F4A7C15ull)) * 0xC4CEB9FE1A85EC53ull) >> 32, range);
+    }
+
+    void build(vector<value_type>& entries, unsigned numThreads) {
+        size_t n = entries.size();
+        if (n == 0) {
+            return;
+        }
+        if (numThreads == 0) {
+            numThreads = max(1u, thread::hardware_concurrency());
+        }
+        vector<uint64_t> hashes(n);
+        runParallel(numThreads, (n + PARTITION_KEYS - 1) / PARTITION_KEYS, [&](size_t chunk) {
+            for (size_t i = chunk * PARTITION_KEYS; i < min(n, (chunk + 1) * PARTITION_KEYS); i++) {
+                hashes[i] = remix(hasher(entries[i].first));
+            }
+        });
+
+        // counting sort of the entries by partition
+        size_t numPartitions = max<size_t>(1, n / PARTITION_KEYS);
+        partitions.assign(numPartitions, Partition{0, 0, 0, 0, 0, 0, 0});
+        for (size_t i = 0; i < n; i++) {
+            partitions[reduce(hashes[i] >> 32, numPartitions)].size++;
+        }
+        size_t offset = 0;
+        size_t numPilots = 0;
+        size_t numRemapped = 0;
+        for (Partition& part : partitions) {
+            part.offset = offset;
+            part.pilots = numPilots;
+            part.remap = numRemapped;
+            part.range = part.size + part.size / 100 + 1;
+            part.buckets = static_cast<uint32_t>(part.size / BUCKET_KEYS + 1);
+            offset += part.size;
+            numPilots += part.buckets;
+            numRemapped += part.range - part.size;
+        }
+        vector<size_t> members(n);
+        vector<size_t> fill(numPartitions);
+        for (size_t i = 0; i < n; i++) {
+            size_t p = reduce(hashes[i] >> 32, numPartitions);
+            members[partitions[p].offset + fill[p]++] = i;
+        }
+
+        // each partition assigns an index to each of its members
+        pilots.assign(numPilots, 0);
+        remap.assign(numRemapped, 0);
+        vector<size_t> indexOf(n);
+        runParallel(numThreads, numPartitions, [&](size_t p) {
+            buildPartition(partitions[p], entries, hashes, members, indexOf);
+        });
+
+        vector<size_t> order(n);
+        for (size_t i = 0; i < n; i++) {
+            order[indexOf[i]] = i;
+        }
+        slots.reserve(n);
+        for (size_t i : order) {
+            slots.push_back(move(entries[i]));
+        }
+    }
+
+    // finds the pilots of one partition and records the index of each of its entries
+    void buildPartition(Partition& part, const vector<value_type>& entries, const vector<uint64_t>& hashes,
+                        const vector<size_t>& members, vector<size_t>& indexOf) {
+        if (part.size == 0) {
+            return;
+        }
+        // sort the members by bucket and hash, so each bucket is a run and equal hashes are adjacent
+        vector<pair<uint64_t, size_t>> items(part.size); // (bucket << 32 | low hash bits, entry)
+        for (size_t j = 0; j < part.size; j++) {
+            size_t i = members[part.offset + j];
+            items[j] = make_pair(static_cast<uint64_t>(reduce(hashes[i] & 0xFFFFFFFF, part.buckets)) << 32 | (hashes[i] & 0xFFFFFFFF), i);
+        }
+        sort(items.begin(), items.end());
+        for (size_t j = 1; j < items.size(); j++) {
+            if (hashes[items[j].second] == hashes[items[j - 1].second]) {
+                throw invalid_argument(equal(entries[items[j].second].first, entries[items[j - 1].second].first)
+                                       ? "Duplicate key in FrozenHashTable"
+                                       : "Keys with equal 64-bit hashes in FrozenHashTable");
+            }
+        }
+
+        // bucket runs, largest first
+        vector<pair<size_t, size_t>> runs; // (start, length) in items
+        for (size_t j = 0; j < items.size(); ) {
+            size_t k = j;
+            while (k < items.size() && items[k].first >> 32 == items[j].first >> 32) {
+                k++;
+            }
+            runs.push_back(make_pair(j, k - j));
+            j = k;
+        }
+        stable_sort(runs.begin(), runs.end(), [](const pair<size_t, size_t>& a, const pair<size_t, size_t>& b) {
+            return a.second > b.second;
+        });
+
+        // a pilot must fit in 16 bits; if one does not, the whole partition starts over with a new seed
+        vector<bool> taken;
+        while (!placeBuckets(part, items, runs, hashes, taken, indexOf)) {
+            part.seed++;
+        }
+
+        // move the keys that landed at or above size into the free indexes below it
+        size_t free = 0;
+        for (size_t pos = part.size; pos < part.range; pos++) {
+            if (taken[pos]) {
+                while (taken[free]) {
+                    free++;
+                }
+                remap[part.remap + pos - part.size] = static_cast<uint32_t>(free++);
+            }
+        }
+        for (size_t j = 0; j < part.size; j++) {
+            size_t i = members[part.offset + j];
+            if (indexOf[i] >= part.size) {
+                indexOf[i] = remap[part.remap + indexOf[i] - part.size];
+            }
+            indexOf[i] += part.offset;
+        }
+    }
+
+    // gives every bucket of the partition the first pilot that puts its keys on free positions,
+    // largest bucket first; false if some bucket needs a pilot over MAX_PILOT
+    bool placeBuckets(const Partition& part, const vector<pair<uint64_t, size_t>>& items,
+                      const vector<pair<size_t, size_t>>& runs, const vector<uint64_t>& hashes,
+                      vector<bool>& taken, vector<size_t>& indexOf) {
+        taken.assign(part.range, false);
+        vector<size_t> spots;
+        for (const auto& run : runs) {
+            size_t bucket = items[run.first].first >> 32;
+            for (uint32_t pilot = 0; ; pilot++) {
+                if (pilot > MAX_PILOT) {
+                    return false;
+                }
+                spots.clear();
+                bool fits = true;
+                for (size_t j = run.first; j < run.first + run.second && fits; j++) {
+                    size_t spot = position(hashes[items[j].second], part.seed, pilot, part.range);
+                    fits = !taken[spot] && std::find(spots.begin(), spots.end(), spot) == spots.end();
+                    spots.push_back(spot);
+                }
+                if (fits) {
+                    pilots[part.pilots + bucket] = static_cast<uint16_t>(pilot);
+                    for (size_t j = 0; j < spots.size(); j++) {
+                        taken[spots[j]] = true;
+                        indexOf[items[run.first + j].second] = spots[j];
+                    }
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+
+    // runs task(0) .. task(numTasks - 1) on up to numThreads threads; rethrows the first exception
+    template<typename Task>
+    static void runParallel(unsigned numThreads, size_t numTasks, Task task) {
+        atomic<size_t> next(0);
+        exception_ptr error;
+        mutex errorLock;
+        auto worker = [&]() {
+            for (size_t t = next++; t < numTasks; t = next++) {
+                try {
+                    task(t);
+                } catch (...) {
+                    lock_guard<mutex> lock(errorLock);
+                    if (!error) {
+                        error = current_exception();
+                    }
+                    next = numTasks;
+                }
+            }
+        };
+        vector<thread> threads;
+        for (unsigned t = 1; t < min<size_t>(numThreads, numTasks); t++) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (thread& t : threads) {
+            t.join();
+        }
+        if (error) {
+            rethrow_exception(error);
+        }
+    }
+};
+
+// 64-bit hash of a byte string, used where a hash has to be the same in every build and process
+// (std::hash is not), such as the files of MappedHashTable
+inline uint64_t hashBytes(const void* data, size_t len) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint64_t h = 0x243F6A8885A308D3ull ^ (len * 0x9E3779B97F4A7C15ull);
+    for (; len >= 8; p += 8, len -= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        h = (h ^ word) * 0xFF51AFD7ED558CCDull;
+        h ^= h >> 32;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, p, len);
+    h = (h ^ tail) * 0xC4CEB9FE1A85EC53ull;
+    return h ^ (h >> 33);
+}
+
+// How a key or value is stored in a MappedHashTable record. A trivially copyable type is stored
+// as its bytes; a string is stored as an offset and a length into the file's string blob and is
+// read back as a string_view into the mapping, after checking that it lies inside the blob
+template<typename T, typename Enable = void>
+struct FileField {
+    static_assert(is_trivially_copyable<T>::value, "MappedHashTable stores trivially copyable types and strings");
+    using view_type = T;
+    static const size_t SIZE = sizeof(T);
+
+    static void write(char* field, const T& value, string&) {
+        memcpy(field, &value, sizeof(T));
+    }
+
+    static T read(const char* field, string_view) {
+        T value;
+        memcpy(&value, field, sizeof(T));
+        return value;
+    }
+
+    static uint64_t hash(const T& value) {
+        return hashBytes(&value, sizeof(T));
+    }
+
+    static bool equals(const char* field, string_view, const T& value) {
+        return memcmp(field, &value, sizeof(T)) == 0;
+    }
+};
+
+template<>
+struct FileField<string> {
+    using view_type = string_view;
+    static const size_t SIZE = 16; // uint64_t offset, uint64_t length
+
+    static void write(char* field, string_view value, string& blob) {
+        uint64_t where[2] = {blob.size(), value.size()};
+        memcpy(field, where, SIZE);
+        blob.append(value.data(), value.size());
+    }
+
+    // throws runtime_error if the record points outside the blob, which only a corrupt file does
+    static string_view read(const char* field, string_view blob) {
+        uint64_t where[2];
+        memcpy(where, field, SIZE);
+        if (where[0] > blob.size() || where[1] > blob.size() - where[0]) {
+            throw runtime_error("Corrupt hash table record");
+        }
+        return blob.substr(where[0], where[1]);
+    }
+
+    static uint64_t hash(string_view value) {
+        return hashBytes(value.data(), value.size());
+    }
+
+    static bool equals(const char* field, string_view blob, string_view value) {
+        return read(field, blob) == value;
+    }
+};
+
+// Read-only hash table that lives in a file and is queried in place through mmap, so opening a
+// table of any size costs one mapping and the pages are read in as lookups touch them.
+//
+// File layout (native byte order):
+//   header     64 bytes: magic "CPPDSHT\0", version, key and value field sizes, capacity, count,
+//              blob offset and size, checksum of everything after the header, checksum of the
+//              header itself
+//   control    capacity bytes, empty (-128) or the low 7 bits of the key's hash
+//   records    capacity fixed-size records, key field then value field
+//   blob       the characters of every string key and value
+// The probing is HashTable's: groups of 16 control bytes, triangular probing between groups, no
+// deleted markers since the file never changes. Hashes come from hashBytes, so a file can be
+// read by any build.
+//
+// open checks the magic, version, field sizes, header checksum, and that every section fits in
+// the file; verify() additionally checks the data checksum, which reads the whole file. Open
+// stays O(1), so every string read checks its offset and length against the blob instead, and a
+// bit-flipped record throws runtime_error rather than reading past the mapping. write
+// builds the new file next to the old one and renames it over it, so a reader sees either the
+// old table or the new one; reload() maps the current file and swaps it in, and a table already
+// mapped keeps working on the old file until then. A mapped file must only be replaced this way:
+// changing or truncating it in place changes the pages under every reader.
+//
+// Lookups are safe from any number of threads, but reload() unmaps the old file at once, so it
+// must not run while another thread uses the table or any view it returned. A service that swaps
+// tables under concurrent readers should instead open a new MappedHashTable and publish it
+// through a shared_ptr (atomic_store); each reader copies the pointer (atomic_load) and holds it
+// while it uses the returned views, and the old mapping goes away with its last reader.
+template<typename K, typename V>
+class MappedHashTable {
+    public:
+    using key_view = typename FileField<K>::view_type;
+    using value_view = typename FileField<V>::view_type;
+
+    static const uint32_t VERSION = 1;
+
+    explicit MappedHashTable(const string& path) : path(path), data(nullptr), length(0) {
+        map(path);
+    }
+
+    MappedHashTable(const MappedHashTable&) = delete;
+    MappedHashTable& operator=(const MappedHashTable&) = delete;
+
+    ~MappedHashTable() {
+        unmap();
+    }
+
+    // writes the entries of any table with size() and for_each(f(key, value)) to path, replacing
+    // the file atomically
+    template<typename Table>
+    static void write(const string& path, const Table& table) {
+        uint64_t cap = GROUP;
+        while (cap * 7 / 8 < table.size()) {
+            cap *= 2;
+        }
+        size_t recordsOffset = sizeof(Header) + cap;
+        vector<char> image(recordsOffset + cap * RECORD, 0);
+        int8_t* ctrl = reinterpret_cast<int8_t*>(image.data() + sizeof(Header));
+        memset(ctrl, CTRL_EMPTY, cap);
+        string blob;
+        uint64_t count = 0;
+        table.for_each([&](const K& key, const V& val) {
+            uint64_t h = FileField<K>::hash(key);
+            size_t slot = freeSlot(ctrl, cap, h);
+            ctrl[slot] = static_cast<int8_t>(h & 0x7F);
+            char* record = image.data() + recordsOffset + slot * RECORD;
+            FileField<K>::write(record, key, blob);
+            FileField<V>::write(record + FileField<K>::SIZE, val, blob);
+            count++;
+        });
+        image.insert(image.end(), blob.begin(), blob.end());
+
+        Header header;
+        memcpy(header.magic, MAGIC, sizeof(header.magic));
+        header.version = VERSION;
+        header.keySize = FileField<K>::SIZE;
+        header.valueSize = FileField<V>::SIZE;
+        header.capacity = cap;
+        header.count = count;
+        header.blobOffset = recordsOffset + cap * RECORD;
+        header.blobSize = blob.size();
+        header.dataChecksum = hashBytes(image.data() + sizeof(Header), image.size() - sizeof(Header));
+        header.headerChecksum = hashBytes(&header, offsetof(Header, headerChecksum));
+        memcpy(image.data(), &header, sizeof(Header));
+
+        // a unique name next to the target, so concurrent writers and stale files don't collide
+        string temp = path + ".XXXXXX";
+        int fd = ::mkstemp(&temp[0]);
+        if (fd < 0) {
+            throw runtime_error("Cannot create a temporary file for " + path);
+        }
+        size_t done = 0;
+        while (done < image.size()) {
+            ssize_t n = ::write(fd, image.data() + done, image.size() - done);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                ::close(fd);
+                ::unlink(temp.c_str());
+                throw runtime_error("Cannot write " + temp);
+            }
+            done += static_cast<size_t>(n);
+        }
+        bool synced = ::fchmod(fd, 0644) == 0 && ::fsync(fd) == 0;
+        if (::close(fd) != 0 || !synced || ::rename(temp.c_str(), path.c_str()) != 0) {
+            ::unlink(temp.c_str());
+            throw runtime_error("Cannot replace " + path);
+        }
+        // make the rename itself durable
+        size_t slash = path.find_last_of('/');
+        string dir = slash == string::npos ? "." : path.substr(0, slash + 1);
+        int dirFd = ::open(dir.c_str(), O_RDONLY);
+        if (dirFd >= 0) {
+            ::fsync(dirFd);
+            ::close(dirFd);
+        }
+    }
+
+    // maps the file now at the path given to the constructor and switches to it; on error the
+    // table keeps the old mapping and the exception is rethrown. The old mapping is released
+    // immediately: no other thread may be using the table or its views during the call
+    void reload() {
+        MappedHashTable fresh(path);
+        swap(data, fresh.data);
+        swap(length, fresh.length);
+    }
+
+    // true if the checksum over the control bytes, records and blob matches the header
+    bool verify() const {
+        return hashBytes(data + sizeof(Header), length - sizeof(Header)) == header().dataChecksum;
+    }
+
+    size_t size() const {
+        return header().count;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t capacity() const {
+        return header().capacity;
+    }
+
+    // stores the value of the key in out and returns true, or returns false if it is not in the table
+    bool find(const key_view& key, value_view& out) const {
+        const char* record = locate(key);
+        if (record == nullptr) {
+            return false;
+        }
+        out = FileField<V>::read(record + FileField<K>::SIZE, blob());
+        return true;
+    }
+
+    bool contains(const key_view& key) const {
+        return locate(key) != nullptr;
+    }
+
+    // the value of the key, or a default-constructed value (an empty view for strings) if it is
+    // not in the table; string views point into the mapping and stay valid until reload()
+    value_view get(const key_view& key) const {
+        value_view val = value_view();
+        find(key, val);
+        return val;
+    }
+
+    // calls f(key, value) for every entry, in slot order
+    template<typename Function>
+    void for_each(Function f) const {
+        const int8_t* ctrl = control();
+        for (size_t i = 0; i < capacity(); i++) {
+            if (ctrl[i] >= 0) {
+                const char* record = records() + i * RECORD;
+                f(FileField<K>::read(record, blob()), FileField<V>::read(record + FileField<K>::SIZE, blob()));
+            }
+        }
+    }
+
+    friend ostream& operator<<(ostream& stream, const MappedHashTable& table) {
+        table.for_each([&stream](const key_view& key, const value_view& val) {
+            stream << key << ": " << val << endl;
+        });
+        return stream;
+    }
+
+    private:
+    static constexpr const char* MAGIC = "CPPDSHT";   // with its terminating 0, fills magic
+    static constexpr size_t GROUP = 16;
+    static constexpr size_t RECORD = FileField<K>::SIZE + FileField<V>::SIZE;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint16_t keySize;
+        uint16_t valueSize;
+        uint64_t capacity;
+        uint64_t count;
+        uint64_t blobOffset;
+        uint64_t blobSize;
+        uint64_t dataChecksum;
+        uint64_t headerChecksum; // of the bytes before it
+    };
+    static_assert(sizeof(Header) == 64, "MappedHashTable header must be 64 bytes");
+
+    string path;
+    const char* data;   // the mapping, starting with the header
+    size_t length;
+
+    const Header& header() const {
+        return *reinterpret_cast<const Header*>(data);
+    }
+
+    const int8_t* control() const {
+        return reinterpret_cast<const int8_t*>(data + sizeof(Header));
+    }
+
+    const char* records() const {
+        return data + sizeof(Header) + header().capacity;
+    }
+
+    string_view blob() const {
+        return string_view(data + header().blobOffset, header().blobSize);
+    }
+
+    // bit i set for each of the 16 control bytes at ctrl equal to b
+    static uint32_t matchGroup(const int8_t* ctrl, int8_t b) {
+#if defined(__SSE2__)
+        __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(b))));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP; i++) {
+            mask |= static_cast<uint32_t>(ctrl[i] == b) << i;
+        }
+        return mask;
+#endif
+    }
+
+    static size_t freeSlot(const int8_t* ctrl, size_t cap, uint64_t h) {
+        size_t groupMask = cap / GROUP - 1;
+        size_t g = static_cast<size_t>(h >> 7) & groupMask;
+        for (size_t step = 1; ; step++) {
+            uint32_t mask = matchGroup(ctrl + g * GROUP, CTRL_EMPTY);
+            if (mask != 0) {
+                return g * GROUP + __builtin_ctz(mask);
+            }
+            g = (g + step) & groupMask;
+        }
+    }
+
+    // the record of the key, or nullptr
+    const char* locate(const key_view& key) const {
+        uint64_t h = FileField<K>::hash(key);
+        const int8_t* ctrl = control();
+        size_t groupMask = header().capacity / GROUP - 1;
+        size_t g = static_cast<size_t>(h >> 7) & groupMask;
+        int8_t h2 = static_cast<int8_t>(h & 0x7F);
+        for (size_t step = 1; step <= groupMask + 1; step++) {
+            const int8_t* group = ctrl + g * GROUP;
+            for (uint32_t mask = matchGroup(group, h2); mask != 0; mask &= mask - 1) {
+                const char* record = records() + (g * GROUP + __builtin_ctz(mask)) * RECORD;
+                if (FileField<K>::equals(record, blob(), key)) {
+                    return record;
+                }
+            }
+            if (matchGroup(group, CTRL_EMPTY) != 0) {
+                return nullptr;
+            }
+            g = (g + step) & groupMask;
+        }
+        return nullptr;
+    }
+
+    void map(const string& file) {
+        int fd = ::open(file.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw runtime_error("Cannot open " + file);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Header)) {
+            ::close(fd);
+            throw runtime_error("Not a hash table file: " + file);
+        }
+        length = static_cast<size_t>(info.st_size);
+        void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            throw runtime_error("Cannot map " + file);
+        }
+        data = static_cast<const char*>(mapping);
+        ::madvise(mapping, length, MADV_RANDOM); // lookups jump around; read ahead is wasted
+
+        const Header& h = header();
+        string problem;
+        if (memcmp(h.magic, MAGIC, sizeof(h.magic)) != 0) {
+            problem = "Not a hash table file: ";
+        } else if (h.headerChecksum != hashBytes(&h, offsetof(Header, headerChecksum))) {
+            problem = "Corrupt hash table header: ";
+        } else if (h.version != VERSION) {
+            problem = "Unsupported hash table file version: ";
+        } else if (h.keySize != FileField<K>::SIZE || h.valueSize != FileField<V>::SIZE) {
+            problem = "Hash table file has other key or value types: ";
+        } else if (h.capacity < GROUP || (h.capacity & (h.capacity - 1)) != 0 || h.count > h.capacity
+                   || h.blobOffset != sizeof(Header) + h.capacity * (1 + RECORD)
+                   || h.blobOffset > length || h.blobSize != length - h.blobOffset) {
+            problem = "Truncated or corrupt hash table file: ";
+        }
+        if (!problem.empty()) {
+            unmap();
+            throw runtime_error(problem + file);
+        }
+    }
+
+    void unmap() {
+        if (data != nullptr) {
+            ::munmap(const_cast<char*>(data), length);
+        }
+        data = nullptr;
+        length = 0;
+    }
+};
+
+// Bloom filter split into 32-byte blocks, so a key touches a single cache line: the high hash
+// bits pick the block, and the low 32 bits, multiplied by eight odd constants, pick one bit in
+// each of the block's eight 32-bit words (the split block layout of Parquet and Impala). With
+// AVX2 the eight bits are set or tested with one vector operation. The number of blocks comes
+// from the expected number of keys and the bits per key; at 10 bits per key about 1.3% of absent
+// keys test positive, at 16 about 0.14%. Keys cannot be removed.
+//
+// Keys are hashed with Hash and mixHash, like HashTable. A saved filter must be loaded by a
+// program whose Hash gives the same values, which std::hash only promises within one program
+// run (in practice, for one standard library).
+template<typename K = int, typename Hash = DefaultHash<K>>
+class BlockedBloomFilter {
+    public:
+    explicit BlockedBloomFilter(size_t expectedKeys = 0, double bitsPerKey = 10) : count(0) {
+        if (!(bitsPerKey > 0)) {
+            throw invalid_argument("Bits per key must be positive");
+        }
+        size_t numBlocks = static_cast<size_t>(expectedKeys * bitsPerKey / BLOCK_BITS) + 1;
+        blocks.assign(numBlocks, Block());
+    }
+
+    // filter sized for the keys, with all of them inserted
+    template<typename Q>
+    BlockedBloomFilter(const vector<Q>& keys, double bitsPerKey) : BlockedBloomFilter(keys.size(), bitsPerKey) {
+        insert_batch(keys.data(), keys.size());
+    }
+
+    template<typename Q>
+    void insert(const Q& key) {
+        insert_hash(mixHash(hasher(key)));
+    }
+
+    // Inserts n keys, hashing BATCH of them and prefetching their blocks before setting any
+    // bits, so the cache misses of a batch overlap
+    template<typename Q>
+    void insert_batch(const Q* keys, size_t n) {
+        uint64_t hashes[BATCH];
+        for (size_t i = 0; i < n; i += BATCH) {
+            size_t m = min(BATCH, n - i);
+            for (size_t j = 0; j < m; j++) {
+                hashes[j] = mixHash(hasher(keys[i + j]));
+                __builtin_prefetch(&blocks[blockOf(hashes[j])], 1);
+            }
+            for (size_t j = 0; j < m; j++) {
+                insert_hash(hashes[j]);
+            }
+        }
+    }
+
+    // false if the key was certainly never inserted
+    template<typename Q>
+    bool may_contain(const Q& key) const {
+        return may_contain_hash(mixHash(hasher(key)));
+    }
+
+    // insert and may_contain for a key hashed by the caller as mixHash(Hash()(key))
+    void insert_hash(uint64_t h) {
+        Block& block = blocks[blockOf(h)];
+        uint32_t x = static_cast<uint32_t>(h);
+#if defined(__AVX2__)
+        __m256i* words = reinterpret_cast<__m256i*>(block.words);
+        _mm256_store_si256(words, _mm256_or_si256(_mm256_load_si256(words), bitMask(x)));
+#else
+        for (size_t i = 0; i < WORDS; i++) {
+            block.words[i] |= 1u << ((x * SALT[i]) >> 27);
+        }
+#endif
+        count++;
+    }
+
+    bool may_contain_hash(uint64_t h) const {
+        const Block& block = blocks[blockOf(h)];
+        uint32_t x = static_cast<uint32_t>(h);
+#if defined(__AVX2__)
+        // testc is 1 when every bit of the mask is set in the block
+        return _mm256_testc_si256(_mm256_load_si256(reinterpret_cast<const __m256i*>(block.words)), bitMask(x)) != 0;
+#else
+        for (size_t i = 0; i < WORDS; i++) {
+            if ((block.words[i] & (1u << ((x * SALT[i]) >> 27))) == 0) {
+                return false;
+            }
+        }
+        return true;
+#endif
+    }
+
+    // number of insertions, counting repeated keys each time
+    size_t size() const {
+        return count;
+    }
+
+    size_t bit_count() const {
+        return blocks.size() * BLOCK_BITS;
+    }
+
+    void clear() {
+        blocks.assign(blocks.size(), Block());
+        count = 0;
+    }
+
+    // Writes the filter as a 32-byte header (magic "CPPDSBF\0", version, blocks, insertions,
+    // checksum of the blocks) followed by the blocks, in native byte order
+    void save(ostream& stream) const {
+        uint64_t header[4] = {0, blocks.size(), count, hashBytes(blocks.data(), blocks.size() * sizeof(Block))};
+        memcpy(&header[0], MAGIC, 8);
+        stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+        stream.write(reinterpret_cast<const char*>(blocks.data()), blocks.size() * sizeof(Block));
+        if (!stream) {
+            throw runtime_error("Cannot write Bloom filter");
+        }
+    }
+
+    static BlockedBloomFilter load(istream& stream) {
+        uint64_t header[4];
+        if (!stream.read(reinterpret_cast<char*>(header), sizeof(header)) || memcmp(&header[0], MAGIC, 8) != 0
+            || header[1] == 0) {
+            throw runtime_error("Not a Bloom filter");
+        }
+        BlockedBloomFilter filter;
+        filter.blocks.resize(header[1]);
+        filter.count = header[2];
+        if (!stream.read(reinterpret_cast<char*>(filter.blocks.data()), header[1] * sizeof(Block))
+            || hashBytes(filter.blocks.data(), header[1] * sizeof(Block)) != header[3]) {
+            throw runtime_error("Truncated or corrupt Bloom filter");
+        }
+        return filter;
+    }
+
+    private:
+    static constexpr size_t WORDS = 8;
+    static constexpr size_t BLOCK_BITS = WORDS * 32;
+    static constexpr size_t BATCH = 16;
+    static constexpr const char* MAGIC = "CPPDSBF";   // with its terminating 0, version 0
+    static constexpr uint32_t SALT[WORDS] = {0x47B6137Bu, 0x44974D91u, 0x8824AD5Bu, 0xA2B7289Du,
+                                             0x705495C7u, 0x2DF1424Bu, 0x9EFC4947u, 0x5C6BFB31u};
+
+    struct alignas(32) Block {
+        uint32_t words[WORDS] = {};
+    };
+
+    vector<Block> blocks;
+    size_t count;
+    Hash hasher;
+
+    size_t blockOf(uint64_t h) const {
+        return static_cast<size_t>(((h >> 32) * blocks.size()) >> 32);
+    }
+
+#if defined(__AVX2__)
+    // one bit in each 32-bit lane, chosen by the top 5 bits of x times the lane's salt
+    static __m256i bitMask(uint32_t x) {
+        __m256i salt = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(SALT));
+        __m256i shifts = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(x)), salt), 27);
+        return _mm256_sllv_epi32(_mm256_set1_epi32(1), shifts);
+    }
+#endif
+};
+
+// HashTable with a BlockedBloomFilter in front of it: a lookup of an absent key usually ends at
+// the filter, after one cache line, instead of probing the table. Every put also inserts the
+// key into the filter. Erased keys stay in the filter and only cost false positives; the filter
+// is rebuilt from the table once stale keys make up half of its insertions, and grows with the
+// table. Lookups take the key's type through, like HashTable's.
+template<typename K = int, typename V = string, typename Hash = DefaultHash<K>, typename Equal = DefaultEqual<K>>
+class FilteredHashTable {
+    public:
+    explicit FilteredHashTable(size_t capacity = 0, double bitsPerKey = 10)
+        : table(capacity), filter(max<size_t>(capacity, MIN_KEYS), bitsPerKey), bitsPerKey(bitsPerKey),
+          planned(max<size_t>(capacity, MIN_KEYS)) {}
+
+    size_t size() const {
+        return table.size();
+    }
+
+    bool empty() const {
+        return table.empty();
+    }
+
+    bool put(const K& key, V val) {
+        if (!table.put(key, move(val))) {
+            return false;
+        }
+        if (table.size() > planned) {
+            rebuild(2 * table.size());
+        }
+        filter.insert(key);
+        return true;
+    }
+
+    template<typename Q>
+    V* find(const Q& key) {
+        return filter.may_contain(key) ? table.find(key) : nullptr;
+    }
+
+    template<typename Q>
+    const V* find(const Q& key) const {
+        return filter.may_contain(key) ? table.find(key) : nullptr;
+    }
+
+    template<typename Q>
+    bool contains(const Q& key) const {
+        return find(key) != nullptr;
+    }
+
+    template<typename Q>
+    V get(const Q& key) const {
+        const V* val = find(key);
+        return val == nullptr ? V() : *val;
+    }
+
+    template<typename Q>
+    bool erase(const Q& key) {
+        if (!table.erase(key)) {
+            return false;
+        }
+        if (filter.size() > 2 * table.size() + MIN_KEYS) {
+            rebuild(planned);
+        }
+        return true;
+    }
+
+    template<typename Function>
+    void for_each(Function f) const {
+        table.for_each(f);
+    }
+
+    const HashTable<K, V, Hash, Equal>& base() const {
+        return table;
+    }
+
+    const BlockedBloomFilter<K, Hash>& bloom_filter() const {
+        return filter;
+    }
+
+    friend ostream& operator<<(ostream& stream, const FilteredHashTable& table) {
+        return stream << table.table;
+    }
+
+    private:
+    static constexpr size_t MIN_KEYS = 1024;
+
+    HashTable<K, V, Hash, Equal> table;
+    BlockedBloomFilter<K, Hash> filter;
+    double bitsPerKey;
+    size_t planned;   // keys the filter was sized for
+
+    // a new filter sized for n keys, holding the keys now in the table
+    void rebuild(size_t n) {
+        planned = max(n, MIN_KEYS);
+        filter = BlockedBloomFilter<K, Hash>(planned, bitsPerKey);
+        table.for_each([this](const K& key, const V&) { filter.insert(key); });
+    }
+};
+
+// Bucketized cuckoo hash table, for when the worst-case lookup matters more than the average.
+// Every key has two candidate buckets of SLOTS (4) entries: the first from its hash, the second
+// from the first and an 8-bit tag of the hash (the partial-key scheme of MemC3, so an entry can
+// be moved to its other bucket without rehashing its key). A lookup compares the tags of the two
+// buckets and the keys whose tags match, and never looks anywhere else. Each bucket is aligned
+// to a cache line and starts with a version and the 4 tags, followed by the 4 entries: when the
+// entries fit in the remaining 56 bytes (pair<int, int>, pair<int, float>) a lookup reads exactly
+// two cache lines, and otherwise the first line of both buckets plus the line of each entry whose
+// tag matches.
+//
+// An insert whose buckets are both full searches breadth first, up to MAX_DEPTH moves away, for
+// the shortest chain of entries that can each move to their other bucket and end in a free
+// slot, then performs the moves from the far end so every entry stays findable. If there is no
+// such chain the table doubles; with 4-way buckets that happens at around 95% occupancy.
+//
+// For trivially copyable keys and values, find_optimistic can run on any number of threads while
+// one thread at a time writes: every change to a bucket makes its version odd and then even
+// again, a reader retries when either bucket's version moved, and bucket arrays replaced by a
+// resize are freed through EpochDomain once no reader can still be in them.
+template<typename K = int, typename V = string, typename Hash = DefaultHash<K>, typename Equal = DefaultEqual<K>>
+class CuckooHashTable {
+    public:
+    using value_type = pair<K, V>;
+    static constexpr size_t SLOTS = 4;
+
+    explicit CuckooHashTable(size_t capacity = 0) : table(new Table(bucketsFor(capacity))), count(0) {}
+
+    CuckooHashTable(const CuckooHashTable& other)
+        : table(new Table(bucketsFor(other.count))), count(0), hasher(other.hasher), equal(other.equal) {
+        other.for_each([this](const K& key, const V& val) { put(key, val); });
+    }
+
+    CuckooHashTable(CuckooHashTable&& other) noexcept
+        : table(other.table.exchange(new Table(MIN_BUCKETS))), count(other.count),
+          hasher(move(other.hasher)), equal(move(other.equal)) {
+        other.count = 0;
+    }
+
+    CuckooHashTable& operator=(CuckooHashTable other) {
+        Table* mine = table.load();
+        table.store(other.table.load());
+        other.table.store(mine);
+        swap(count, other.count);
+        swap(hasher, other.hasher);
+        swap(equal, other.equal);
+        return *this;
+    }
+
+    ~CuckooHashTable() {
+        clear();
+        delete table.load();
+        for (auto& item : retired) {
+            delete item.second;
+        }
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    // number of slots, SLOTS times a power of two
+    size_t capacity() const {
+        return current().numBuckets() * SLOTS;
+    }
+
+    float load_factor() const {
+        return static_cast<float>(count) / capacity();
+    }
+
+    // makes room for n keys at the planned occupancy; inserts can still grow the table early if
+    // an eviction chain cannot be found
+    void reserve(size_t n) {
+        if (bucketsFor(n) > current().numBuckets()) {
+            rehash(bucketsFor(n));
+        }
+    }
+
+    // inserts the key or replaces its value; returns true if the key was new
+    bool put(const K& key, V val) {
+        uint64_t h = hashOf(key);
+        Table& t = current();
+        size_t b;
+        size_t s;
+        if (locate(t, key, h, b, s)) {
+            Bucket& bucket = t.buckets[b];
+            beginWrite(bucket);
+            bucket.slot(s).second = move(val);
+            endWrite(bucket);
+            return false;
+        }
+        while (!insertNew(current(), key, val, h)) {
+            // no eviction chain: double the table, up to MAX_GROWTH times the normal size
+            if (current().numBuckets() >= bucketsFor(count + 1) * MAX_GROWTH) {
+                throw length_error("Hash function puts too many keys in one place");
+            }
+            rehash(current().numBuckets() * 2);
+        }
+        count++;
+        return true;
+    }
+
+    // returns a pointer to the value of the key, or nullptr if it is not in the table
+    template<typename Q>
+    V* find(const Q& key) {
+        size_t b;
+        size_t s;
+        Table& t = current();
+        return locate(t, key, hashOf(key), b, s) ? &t.buckets[b].slot(s).second : nullptr;
+    }
+
+    template<typename Q>
+    const V* find(const Q& key) const {
+        size_t b;
+        size_t s;
+        const Table& t = current();
+        return locate(t, key, hashOf(key), b, s) ? &t.buckets[b].slot(s).second : nullptr;
+    }
+
+    template<typename Q>
+    bool contains(const Q& key) const {
+        return find(key) != nullptr;
+    }
+
+    template<typename Q>
+    V get(const Q& key) const {
+        const V* val = find(key);
+        return val == nullptr ? V() : *val;
+    }
+
+    // Copies the value of the key into out; returns false if the key is absent. Safe to call
+    // from any number of threads while a single thread calls put, erase or reserve
+    template<typename Q>
+    bool find_optimistic(const Q& key, V& out) const {
+        static_assert(is_trivially_copyable<K>::value && is_trivially_copyable<V>::value,
+                      "find_optimistic needs trivially copyable keys and values");
+        uint64_t h = hashOf(key);
+        uint8_t tag = tagOf(h);
+        EpochDomain& epochs = EpochDomain::instance();
+        size_t slot = epochs.slot();
+        if (slot == EpochDomain::NO_SLOT) {
+            throw runtime_error("Too many concurrent readers");
+        }
+        epochs.enter(slot);
+        for (;;) {
+            const Table* t = table.load(memory_order_acquire);
+            size_t b1 = firstBucket(*t, h);
+            size_t b2 = altBucket(*t, b1, tag);
+            const Bucket& first = t->buckets[b1];
+            const Bucket& second = t->buckets[b2];
+            uint32_t v1 = first.version.load(memory_order_acquire);
+            uint32_t v2 = second.version.load(memory_order_acquire);
+            if ((v1 | v2) & 1) {
+                this_thread::yield();
+                continue;
+            }
+            int found = copyIfPresent(first, key, tag, out);
+            if (found == 0) {
+                found = copyIfPresent(second, key, tag, out);
+            }
+            atomic_thread_fence(memory_order_acquire);
+            if (first.version.load(memory_order_relaxed) == v1 && second.version.load(memory_order_relaxed) == v2
+                && table.load(memory_order_relaxed) == t) {
+                epochs.leave(slot);
+                return found != 0;
+            }
+        }
+    }
+
+    // removes the key; returns true if it was in the table
+    template<typename Q>
+    bool erase(const Q& key) {
+        size_t b;
+        size_t s;
+        Table& t = current();
+        if (!locate(t, key, hashOf(key), b, s)) {
+            return false;
+        }
+        Bucket& bucket = t.buckets[b];
+        beginWrite(bucket);
+        bucket.tags[s] = 0;
+        bucket.slot(s).~value_type();
+        endWrite(bucket);
+        count--;
+        return true;
+    }
+
+    void clear() {
+        Table& t = current();
+        for (size_t b = 0; b < t.numBuckets(); b++) {
+            Bucket& bucket = t.buckets[b];
+            beginWrite(bucket);
+            for (size_t s = 0; s < SLOTS; s++) {
+                if (bucket.tags[s] != 0) {
+                    bucket.tags[s] = 0;
+                    bucket.slot(s).~value_type();
+                }
+            }
+            endWrite(bucket);
+        }
+        count = 0;
+    }
+
+    // calls f(key, value) for every entry, in bucket order
+    template<typename Function>
+    void for_each(Function f) const {
+        const Table& t = current();
+        for (size_t b = 0; b < t.numBuckets(); b++) {
+            for (size_t s = 0; s < SLOTS; s++) {
+                if (t.buckets[b].tags[s] != 0) {
+                    f(t.buckets[b].slot(s).first, t.buckets[b].slot(s).second);
+                }
+            }
+        }
+    }
+
+    friend ostream& operator<<(ostream& stream, const CuckooHashTable& table) {
+        table.for_each([&stream](const K& key, const V& val) {
+            stream << key << ": " << val << endl;
+        });
+        return stream;
+    }
+
+    private:
+    static constexpr size_t MIN_BUCKETS = 4;
+    static constexpr size_t MAX_DEPTH = 5;       // moves in one eviction chain
+    static constexpr size_t MAX_STEPS = 512;     // buckets the eviction search may visit
+    static constexpr float PLANNED_LOAD = 0.9f;  // occupancy reserve plans for
+    static constexpr size_t MAX_GROWTH = 8;      // how far past its normal size the table grows to place a key
+
+    struct alignas(64) Bucket {
+        atomic<uint32_t> version{0};  // odd while the bucket is being changed
+        uint8_t tags[SLOTS] = {};     // 0 for an empty slot
+        alignas(value_type) unsigned char storage[SLOTS * sizeof(value_type)];
+
+        value_type& slot(size_t s) {
+            return reinterpret_cast<value_type*>(storage)[s];
+        }
+
+        const value_type& slot(size_t s) const {
+            return reinterpret_cast<const value_type*>(storage)[s];
+        }
+
+        // the high bit of byte i (little-endian) is set exactly when tags[i] == tag: an exact
+        // zero-byte test on the 4 tags as one word. Tags are never 0, so empty slots never match;
+        // the borrow-based test could flag the byte above a true match, i.e. an empty slot
+        uint32_t match(uint8_t tag) const {
+            uint32_t word;
+            memcpy(&word, tags, sizeof(word));
+            uint32_t x = word ^ (tag * 0x01010101u);
+            return ~(((x & 0x7F7F7F7Fu) + 0x7F7F7F7Fu) | x | 0x7F7F7F7Fu);
+        }
+
+        int freeSlot() const {
+            for (size_t s = 0; s < SLOTS; s++) {
+                if (tags[s] == 0) {
+                    return static_cast<int>(s);
+                }
+            }
+            return -1;
+        }
+    };
+
+    // the bucket array; replaced as a whole when the table grows
+    struct Table {
+        size_t mask;
+        Bucket* buckets;
+
+        explicit Table(size_t numBuckets) : mask(numBuckets - 1), buckets(new Bucket[numBuckets]) {}
+        ~Table() {
+            delete[] buckets;
+        }
+
+        size_t numBuckets() const {
+            return mask + 1;
+        }
+    };
+
+    // a bucket reached by the eviction search, and the move that leads to it
+    struct Step {
+        size_t bucket;
+        size_t parent;   // index in the search of the bucket whose entry moves here, or NONE
+        size_t slot;     // slot of that entry in the parent bucket
+        size_t depth;
+    };
+    static constexpr size_t NONE = static_cast<size_t>(-1);
+
+    atomic<Table*> table;
+    size_t count;
+    Hash hasher;
+    Equal equal;
+    vector<pair<uint64_t, Table*>> retired;  // epoch at retirement, table
+
+    Table& current() {
+        return *table.load(memory_order_relaxed);
+    }
+
+    const Table& current() const {
+        return *table.load(memory_order_relaxed);
+    }
+
+    static size_t bucketsFor(size_t n) {
+        size_t numBuckets = MIN_BUCKETS;
+        while (numBuckets * SLOTS * PLANNED_LOAD < n) {
+            numBuckets *= 2;
+        }
+        return numBuckets;
+    }
+
+    template<typename Q>
+    uint64_t hashOf(const Q& key) const {
+        return mixHash(hasher(key));
+    }
+
+    static uint8_t tagOf(uint64_t h) {
+        uint8_t tag = static_cast<uint8_t>(h);
+        return tag == 0 ? 1 : tag;
+    }
+
+    static size_t firstBucket(const Table& t, uint64_t h) {
+        return static_cast<size_t>(h >> 32) & t.mask;
+    }
+
+    // the other bucket of an entry in bucket b; applying it twice gives b back
+    static size_t altBucket(const Table& t, size_t b, uint8_t tag) {
+        return (b ^ (tag * 0x5BD1E995ull)) & t.mask;
+    }
+
+    template<typename Q>
+    bool locate(const Table& t, const Q& key, uint64_t h, size_t& b, size_t& s) const {
+        uint8_t tag = tagOf(h);
+        size_t b1 = firstBucket(t, h);
+        size_t candidates[2] = {b1, altBucket(t, b1, tag)};
+        __builtin_prefetch(&t.buckets[candidates[1]]); // both misses at once, not one after the other
+        for (size_t c : candidates) {
+            const Bucket& bucket = t.buckets[c];
+            for (uint32_t mask = bucket.match(tag); mask != 0; mask &= mask - 1) {
+                size_t i = __builtin_ctz(mask) / 8;
+                if (equal(bucket.slot(i).first, key)) {
+                    b = c;
+                    s = i;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // 1 and the value copied to out if the key is in the bucket, else 0; reads through memcpy,
+    // since a writer may be changing the bucket and the version check decides afterwards
+    template<typename Q>
+    int copyIfPresent(const Bucket& bucket, const Q& key, uint8_t tag, V& out) const {
+        for (uint32_t mask = bucket.match(tag); mask != 0; mask &= mask - 1) {
+            size_t i = __builtin_ctz(mask) / 8;
+            K k;
+            memcpy(&k, &bucket.slot(i).first, sizeof(K));
+            if (equal(k, key)) {
+                memcpy(&out, &bucket.slot(i).second, sizeof(V));
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    static void beginWrite(Bucket& bucket) {
+        bucket.version.store(bucket.version.load(memory_order_relaxed) + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+    }
+
+    static void endWrite(Bucket& bucket) {
+        bucket.version.store(bucket.version.load(memory_order_relaxed) + 1, memory_order_release);
+    }
+
+    static void place(Bucket& bucket, size_t s, uint8_t tag, value_type&& entry) {
+        beginWrite(bucket);
+        new (&bucket.slot(s)) value_type(move(entry));
+        bucket.tags[s] = tag;
+        endWrite(bucket);
+    }
+
+    // moves the entry in slot s of bucket from to slot d of bucket to; the entry is in both
+    // buckets for a moment, never in neither
+    static void moveEntry(Bucket& from, size_t s, Bucket& to, size_t d) {
+        uint8_t tag = from.tags[s];
+        place(to, d, tag, move(from.slot(s)));
+        beginWrite(from);
+        from.tags[s] = 0;
+        from.slot(s).~value_type();
+        endWrite(from);
+    }
+
+    // inserts a key known to be absent; false if both buckets are full and no eviction chain
+    // was found, in which case the table is unchanged
+    bool insertNew(Table& t, const K& key, V& val, uint64_t h) {
+        uint8_t tag = tagOf(h);
+        size_t b1 = firstBucket(t, h);
+        size_t b2 = altBucket(t, b1, tag);
+        for (size_t b : {b1, b2}) {
+            int free = t.buckets[b].freeSlot();
+            if (free >= 0) {
+                place(t.buckets[b], static_cast<size_t>(free), tag, value_type(key, move(val)));
+                return true;
+            }
+        }
+
+        vector<Step> steps = {{b1, NONE, 0, 0}};
+        if (b2 != b1) {
+            steps.push_back({b2, NONE, 0, 0});
+        }
+        for (size_t n = 0; n < steps.size(); n++) {
+            Bucket& bucket = t.buckets[steps[n].bucket];
+            int free = bucket.freeSlot();
+            if (free >= 0) {
+                // shift every entry on the path one step towards the free slot, far end first
+                size_t at = n;
+                size_t target = static_cast<size_t>(free);
+                while (steps[at].parent != NONE) {
+                    const Step& step = steps[at];
+                    moveEntry(t.buckets[steps[step.parent].bucket], step.slot, t.buckets[step.bucket], target);
+                    target = step.slot;
+                    at = step.parent;
+                }
+                place(t.buckets[steps[at].bucket], target, tag, value_type(key, move(val)));
+                return true;
+            }
+            if (steps[n].depth == MAX_DEPTH) {
+                continue;
+            }
+            for (size_t s = 0; s < SLOTS && steps.size() < MAX_STEPS; s++) {
+                size_t alt = altBucket(t, steps[n].bucket, bucket.tags[s]);
+                bool seen = false;
+                for (const Step& step : steps) {
+                    seen = seen || step.bucket == alt;
+                }
+                if (!seen) {
+                    steps.push_back({alt, n, s, steps[n].depth + 1});
+                }
+            }
+        }
+        return false;
+    }
+
+    // moves every entry into a new array of numBuckets buckets, publishes it and retires the old
+    // one; if the entries do not fit even in MAX_GROWTH times that, throws length_error and
+    // leaves the table as it was
+    void rehash(size_t numBuckets) {
+        Table& old = current();
+        Table* bigger = moveAll(old, numBuckets, max(numBuckets, bucketsFor(count + 1)) * MAX_GROWTH);
+        table.store(bigger, memory_order_release);
+        retire(&old);
+    }
+
+    // A new array of numBuckets buckets, or more if some entry does not fit (up to limit),
+    // holding the entries of from, whose values are left moved-from. The old array stays
+    // readable for optimistic readers until it is retired: for their types, moving is copying
+    Table* moveAll(Table& from, size_t numBuckets, size_t limit) {
+        Table* to = new Table(numBuckets);
+        try {
+            for (size_t b = 0; b < from.numBuckets(); b++) {
+                for (size_t s = 0; s < SLOTS; s++) {
+                    if (from.buckets[b].tags[s] != 0) {
+                        value_type& entry = from.buckets[b].slot(s);
+                        // insertNew copies the key, and moves the value only once it has a place
+                        while (!insertNew(*to, entry.first, entry.second, hashOf(entry.first))) {
+                            if (to->numBuckets() >= limit) {
+                                throw length_error("Hash function puts too many keys in one place");
+                            }
+                            Table* more = moveAll(*to, to->numBuckets() * 2, limit);
+                            delete to;
+                            to = more;
+                        }
+                    }
+                }
+            }
+        } catch (...) {
+            // the keys are all still in from, so every moved value can find its way back
+            for_each_entry(*to, [&](value_type& entry) {
+                size_t b;
+                size_t s;
+                if (locate(from, entry.first, hashOf(entry.first), b, s)) {
+                    from.buckets[b].slot(s).second = move(entry.second);
+                }
+            });
+            destroyEntries(*to);
+            delete to;
+            throw;
+        }
+        destroyEntries(from);
+        return to;
+    }
+
+    template<typename Function>
+    static void for_each_entry(Table& t, Function f) {
+        for (size_t b = 0; b < t.numBuckets(); b++) {
+            for (size_t s = 0; s < SLOTS; s++) {
+                if (t.buckets[b].tags[s] != 0) {
+                    f(t.buckets[b].slot(s));
+                }
+            }
+        }
+    }
+
+    // runs the destructors of the entries; the tags stay, as readers may still be looking
+    static void destroyEntries(Table& t) {
+        if constexpr (!is_trivially_destructible<value_type>::value) {
+            for_each_entry(t, [](value_type& entry) { entry.~value_type(); });
+        }
+    }
+
+    // frees the bucket array once no optimistic reader can be in it, along with older ones
+    void retire(Table* t) {
+        if constexpr (!(is_trivially_copyable<K>::value && is_trivially_copyable<V>::value)) {
+            delete t; // no optimistic readers for these types
+            return;
+        }
+        EpochDomain& epochs = EpochDomain::instance();
+        retired.push_back(make_pair(epochs.advance(), t));
+        size_t kept = 0;
+        for (auto& item : retired) {
+            if (epochs.safe(item.first)) {
+                delete item.second;
+            } else {
+                retired[kept++] = item;
+            }
+        }
+        retired.resize(kept);
+    }
+};
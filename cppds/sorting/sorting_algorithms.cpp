@@ -1,5 +1,10 @@
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include <functional>  // std::less
+#include <iterator>
+#include <future>      // std::async, for parallel merge sort
+#include <thread>
 using namespace std;
 
 //function goes through list sorting adjacent values as it bubbles
@@ -118,49 +123,137 @@ vector<int> shellSort(vector<int> avector) {
     return avector;
 }
 
-//function sorts using mergesort.
-vector<int> mergeSort(vector<int> avector) {
-    cout<<"Splitting ";
-    printl(avector);
-    if (avector.size()>1) {
-        int mid = avector.size()/2;
-        //C++ Equivalent to using Python Slices
-        vector<int> lefthalf(avector.begin(),avector.begin()+mid);
-        vector<int> righthalf(avector.begin()+mid,avector.begin()+avector.size());
-
-        lefthalf = mergeSort(lefthalf);
-        righthalf = mergeSort(righthalf);
-
-        unsigned i = 0;
-        unsigned j = 0;
-        unsigned k = 0;
-        while (i < lefthalf.size() && j < righthalf.size()) {
-            if (lefthalf[i] < righthalf[j]) {
-                avector[k]=lefthalf[i];
-                i++;
-            } else {
-                avector[k] = righthalf[j];
-                j++;
-            }
-            k++;
+// Merge sort internals. The data ping-pongs between the input and one scratch buffer of the same
+// size: each call sorts [a, a + n) and leaves the result in a or, if toB is set, in the matching
+// range of b, using the other array as room for its halves. Runs of up to INSERTION_RUN elements
+// are insertion sorted. With more than one thread the halves are sorted concurrently and the
+// final merge is split between the threads along the merge path.
+namespace merge_sort_detail {
+
+const ptrdiff_t INSERTION_RUN = 32;       // insertion sort below this
+const ptrdiff_t PARALLEL_MIN = 1 << 14;   // no threads for smaller ranges
+
+template<typename RandomIt, typename Compare>
+void insertionSort(RandomIt first, RandomIt last, Compare comp) {
+    for (RandomIt i = first + 1; i < last; i++) {
+        auto value = move(*i);
+        RandomIt j = i;
+        while (j > first && comp(value, *(j - 1))) {
+            *j = move(*(j - 1));
+            j--;
         }
+        *j = move(value);
+    }
+}
 
-        while (i<lefthalf.size()) {
-            avector[k] = lefthalf[i];
-            i++;
-            k++;
+// Stable merge of [x, x + p) and [y, y + q) into out; on ties the element of x comes first
+template<typename InIt, typename OutIt, typename Compare>
+void merge(InIt x, ptrdiff_t p, InIt y, ptrdiff_t q, OutIt out, Compare comp) {
+    ptrdiff_t i = 0;
+    ptrdiff_t j = 0;
+    while (i < p && j < q) {
+        if (comp(y[j], x[i])) {
+            *out++ = move(y[j++]);
+        } else {
+            *out++ = move(x[i++]);
         }
+    }
+    out = move(x + i, x + p, out);
+    move(y + j, y + q, out);
+}
 
-        while (j<righthalf.size()) {
-            avector[k]=righthalf[j];
-            j++;
-            k++;
+// Number of elements of x among the first d elements of the merge of x and y: a binary search
+// along the d-th diagonal of the merge path
+template<typename InIt, typename Compare>
+ptrdiff_t coRank(ptrdiff_t d, InIt x, ptrdiff_t p, InIt y, ptrdiff_t q, Compare comp) {
+    ptrdiff_t lo = max<ptrdiff_t>(0, d - q);
+    ptrdiff_t hi = min(d, p);
+    while (lo < hi) {
+        ptrdiff_t i = lo + (hi - lo) / 2;
+        if (!comp(y[d - i - 1], x[i])) {
+            lo = i + 1;   // x[i] comes before y[d - i - 1], so it is among the first d
+        } else {
+            hi = i;
         }
+    }
+    return lo;
+}
 
+// merge split into numThreads pieces of equal output size, each merged on its own thread
+template<typename InIt, typename OutIt, typename Compare>
+void parallelMerge(InIt x, ptrdiff_t p, InIt y, ptrdiff_t q, OutIt out, Compare comp, unsigned numThreads) {
+    // all split points first: a running piece moves elements out from under the binary searches
+    ptrdiff_t n = p + q;
+    vector<ptrdiff_t> split(numThreads + 1, 0);
+    for (unsigned t = 1; t <= numThreads; t++) {
+        split[t] = t == numThreads ? p : coRank(n * t / numThreads, x, p, y, q, comp);
+    }
+    vector<future<void>> pieces;
+    for (unsigned t = 0; t < numThreads; t++) {
+        ptrdiff_t begin = n * t / numThreads;
+        ptrdiff_t end = n * (t + 1) / numThreads;
+        ptrdiff_t i = split[t];
+        ptrdiff_t j = begin - i;
+        auto piece = [=, &split]() { merge(x + i, split[t + 1] - i, y + j, (end - split[t + 1]) - j, out + begin, comp); };
+        if (t + 1 == numThreads) {
+            piece();
+        } else {
+            pieces.push_back(async(launch::async, piece));
+        }
     }
-    cout<<"Merging ";
-    printl(avector);
+    for (auto& piece : pieces) {
+        piece.get();
+    }
+}
 
+template<typename It1, typename It2, typename Compare>
+void sort(It1 a, It2 b, ptrdiff_t n, bool toB, Compare comp, unsigned numThreads) {
+    if (n <= INSERTION_RUN) {
+        insertionSort(a, a + n, comp);
+        if (toB) {
+            move(a, a + n, b);
+        }
+        return;
+    }
+    ptrdiff_t half = n / 2;
+    if (numThreads > 1 && n >= PARALLEL_MIN) {
+        unsigned leftThreads = numThreads / 2;
+        auto left = async(launch::async, [=]() { sort(a, b, half, !toB, comp, leftThreads); });
+        sort(a + half, b + half, n - half, !toB, comp, numThreads - leftThreads);
+        left.get();
+    } else {
+        sort(a, b, half, !toB, comp, 1);
+        sort(a + half, b + half, n - half, !toB, comp, 1);
+    }
+    // the halves are in the other array
+    if (toB) {
+        parallelMerge(a, half, a + half, n - half, b, comp, n >= PARALLEL_MIN ? numThreads : 1);
+    } else {
+        parallelMerge(b, half, b + half, n - half, a, comp, n >= PARALLEL_MIN ? numThreads : 1);
+    }
+}
+
+}
+
+// Stable merge sort of [first, last) with one scratch buffer of the same size, allocated once.
+// The elements are moved into the buffer and sorted back into [first, last), so move-only types
+// work and nothing is copied. numThreads = 0 uses one thread per core
+template<typename RandomIt, typename Compare = less<>>
+void mergeSort(RandomIt first, RandomIt last, Compare comp = Compare(), unsigned numThreads = 0) {
+    ptrdiff_t n = last - first;
+    if (n < 2) {
+        return;
+    }
+    if (numThreads == 0) {
+        numThreads = max(1u, thread::hardware_concurrency());
+    }
+    vector<typename iterator_traits<RandomIt>::value_type> buffer(make_move_iterator(first), make_move_iterator(last));
+    merge_sort_detail::sort(buffer.begin(), first, n, true, comp, numThreads);
+}
+
+//function sorts using mergesort.
+vector<int> mergeSort(vector<int> avector) {
+    mergeSort(avector.begin(), avector.end());
     return avector;
 }
 